@@ -0,0 +1,1205 @@
+#include "benchmarks.h"
+
+#include "compressed_posting_list.h"
+#include "concurentmap.h"
+#include "cpu_features.h"
+#include "frozen_segment.h"
+#include "log_duration.h"
+#include "process_queries.h"
+#include "remove_duplicates.h"
+#include "score_table.h"
+#include "scoring_kernel.h"
+#include "search_server.h"
+#include "segmented_search_server.h"
+#include "string_processing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <random>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+string GenerateWord(mt19937& generator, int max_length) {
+    const int length = uniform_int_distribution(1, max_length)(generator);
+    string word;
+    word.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        word.push_back(uniform_int_distribution('a', 'z')(generator));
+    }
+    return word;
+}
+
+vector<string> GenerateDictionary(mt19937& generator, int word_count, int max_length) {
+    vector<string> words;
+    words.reserve(word_count);
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+    sort(words.begin(), words.end());
+    words.erase(unique(words.begin(), words.end()), words.end());
+    return words;
+}
+
+string GenerateQuery(mt19937& generator, const vector<string>& dictionary, int word_count, double minus_prob = 0) {
+    string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            query.push_back('-');
+        }
+        query += dictionary[uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+    }
+    return query;
+}
+
+vector<string> GenerateQueries(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count) {
+    vector<string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    }
+    return queries;
+}
+
+// Для сравнения: прежнее представление индекса "слово -> (id -> TF)".
+using MapIndex = map<string_view, map<int, double>>;
+
+// Оценка размера узла красно-чёрного дерева в libstdc++: цвет + три указателя.
+constexpr size_t RB_NODE_OVERHEAD = 32;
+
+size_t EstimateMapIndexMemory(const MapIndex& index) {
+    size_t bytes = 0;
+    for (const auto& [word, postings] : index) {
+        bytes += RB_NODE_OVERHEAD + sizeof(pair<const string_view, map<int, double>>);
+        bytes += postings.size() * (RB_NODE_OVERHEAD + sizeof(pair<const int, double>));
+    }
+    return bytes;
+}
+
+} // namespace
+
+void BenchmarkPostingLists() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    const auto queries = GenerateQueries(generator, dictionary, 1'000, 7);
+
+    SearchServer search_server(dictionary[0]);
+    for (int i = 0; i < 20'000; ++i) {
+        search_server.AddDocument(i, GenerateQuery(generator, dictionary, 70), DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    MapIndex map_index;
+    map<string_view, PostingList> posting_index;
+    for (const int document_id : search_server) {
+        for (const auto& [word, term_freq] : search_server.GetWordFrequencies(document_id)) {
+            map_index[word][document_id] = term_freq;
+            posting_index[word].Add(document_id, term_freq);
+        }
+    }
+
+    size_t posting_bytes = 0;
+    size_t posting_count = 0;
+    for (const auto& [word, postings] : posting_index) {
+        posting_bytes += RB_NODE_OVERHEAD + sizeof(pair<const string_view, PostingList>) - sizeof(PostingList);
+        posting_bytes += postings.MemoryUsage();
+        posting_count += postings.size();
+    }
+    cerr << "postings: "s << posting_count << endl;
+    cerr << "map<int, double> index: "s << EstimateMapIndexMemory(map_index) << " bytes"s << endl;
+    cerr << "PostingList index: "s << posting_bytes << " bytes"s << endl;
+
+    double checksum = 0;
+    {
+        LOG_DURATION("map<int, double> scan"s);
+        for (const auto& query : queries) {
+            for (const auto word : SplitIntoWords(query)) {
+                const auto it = map_index.find(word);
+                if (it == map_index.end()) {
+                    continue;
+                }
+                for (const auto& [document_id, term_freq] : it->second) {
+                    checksum += term_freq;
+                }
+            }
+        }
+    }
+    {
+        LOG_DURATION("PostingList scan"s);
+        for (const auto& query : queries) {
+            for (const auto word : SplitIntoWords(query)) {
+                const auto it = posting_index.find(word);
+                if (it == posting_index.end()) {
+                    continue;
+                }
+                for (const double term_freq : it->second.GetTermFreqs()) {
+                    checksum -= term_freq;
+                }
+            }
+        }
+    }
+    {
+        LOG_DURATION("FindTopDocuments"s);
+        for (const auto& query : queries) {
+            checksum += search_server.FindTopDocuments(query).size();
+        }
+    }
+    cerr << "checksum: "s << checksum << endl;
+}
+
+void BenchmarkTopDocuments() {
+    mt19937 generator;
+    vector<Document> documents(2'000'000);
+    for (int i = 0; i < static_cast<int>(documents.size()); ++i) {
+        documents[i] = {i, uniform_real_distribution<Relevance>(0, 1)(generator), uniform_int_distribution(-10, 10)(generator)};
+    }
+
+    for (const size_t max_count : {size_t{5}, size_t{50}}) {
+        cerr << "top-"s << max_count << ':' << endl;
+        {
+            LOG_DURATION("full sort"s);
+            auto sorted = documents;
+            sort(sorted.begin(), sorted.end(), IsMoreRelevant);
+            sorted.resize(max_count);
+        }
+        {
+            LOG_DURATION("TopDocumentsSelector"s);
+            SelectTopDocuments(execution::seq, documents, max_count);
+        }
+        {
+            LOG_DURATION("TopDocumentsSelector par"s);
+            SelectTopDocuments(execution::par, documents, max_count);
+        }
+    }
+}
+
+void BenchmarkRelevanceAccumulation() {
+    mt19937 generator;
+    const int document_count = 200'000;
+    // Списки вхождений запроса: каждый поток обрабатывает свою долю
+    vector<vector<int>> postings(5);
+    for (auto& posting : postings) {
+        for (int document_id = 0; document_id < document_count; ++document_id) {
+            if (uniform_int_distribution(0, 3)(generator) == 0) {
+                posting.push_back(document_id);
+            }
+        }
+    }
+
+    const int max_threads = max(4u, thread::hardware_concurrency());
+    for (int thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+        cerr << "threads: "s << thread_count << endl;
+        const auto run_threads = [&postings, thread_count](auto work) {
+            vector<thread> threads;
+            for (int part = 0; part < thread_count; ++part) {
+                threads.emplace_back(work, part);
+            }
+            for (auto& worker : threads) {
+                worker.join();
+            }
+        };
+        size_t result_size = 0;
+        {
+            LOG_DURATION("ConcurrentMap"s);
+            ConcurrentMap<int, double> document_to_relevance(16);
+            run_threads([&](int part) {
+                for (const auto& posting : postings) {
+                    const size_t last = posting.size() * (part + 1) / thread_count;
+                    for (size_t i = posting.size() * part / thread_count; i < last; ++i) {
+                        document_to_relevance[posting[i]].ref_to_value += 0.5;
+                    }
+                }
+            });
+            result_size = document_to_relevance.BuildOrdinaryMap().size();
+        }
+        {
+            LOG_DURATION("ScoreTable per thread"s);
+            vector<ScoreTable> tables(thread_count);
+            run_threads([&](int part) {
+                for (const auto& posting : postings) {
+                    const size_t last = posting.size() * (part + 1) / thread_count;
+                    for (size_t i = posting.size() * part / thread_count; i < last; ++i) {
+                        tables[part][posting[i]] += 0.5;
+                    }
+                }
+            });
+            for (int part = 1; part < thread_count; ++part) {
+                tables[0].Merge(tables[part]);
+            }
+            if (tables[0].size() != result_size) {
+                cerr << "size mismatch"s << endl;
+            }
+        }
+    }
+}
+
+void BenchmarkAddDocuments() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 10'000, 10);
+    vector<string> texts;
+    for (int i = 0; i < 50'000; ++i) {
+        texts.push_back(GenerateQuery(generator, dictionary, 100));
+    }
+    vector<DocumentToAdd> documents;
+    for (int i = 0; i < static_cast<int>(texts.size()); ++i) {
+        documents.push_back({i, texts[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+    }
+
+    {
+        LOG_DURATION("AddDocument loop"s);
+        SearchServer search_server(dictionary[0]);
+        for (const auto& document : documents) {
+            search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+    }
+    {
+        LOG_DURATION("AddDocuments seq"s);
+        SearchServer search_server(dictionary[0]);
+        search_server.AddDocuments(execution::seq, documents);
+    }
+    {
+        LOG_DURATION("AddDocuments par"s);
+        SearchServer search_server(dictionary[0]);
+        search_server.AddDocuments(execution::par, documents);
+    }
+}
+
+void BenchmarkSnapshotLoad() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 10'000, 10);
+    vector<string> texts;
+    for (int i = 0; i < 50'000; ++i) {
+        texts.push_back(GenerateQuery(generator, dictionary, 100));
+    }
+    vector<DocumentToAdd> documents;
+    for (int i = 0; i < static_cast<int>(texts.size()); ++i) {
+        documents.push_back({i, texts[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+    }
+    const auto queries = GenerateQueries(generator, dictionary, 100, 5);
+    const string path = "bench_snapshot.bin"s;
+
+    size_t result_count = 0;
+    {
+        LOG_DURATION("cold start: AddDocuments + first queries"s);
+        SearchServer search_server(dictionary[0]);
+        search_server.AddDocuments(execution::par, documents);
+        for (const auto& query : queries) {
+            result_count += search_server.FindTopDocuments(query).size();
+        }
+        search_server.SaveSnapshot(path);
+    }
+    {
+        LOG_DURATION("cold start: LoadSnapshot + first queries"s);
+        const auto search_server = SearchServer::LoadSnapshot(path);
+        for (const auto& query : queries) {
+            result_count -= search_server.FindTopDocuments(query).size();
+        }
+    }
+    remove(path.c_str());
+    if (result_count != 0) {
+        cerr << "snapshot results differ"s << endl;
+    }
+}
+
+void BenchmarkTermDictionary() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 200'000, 20);
+    vector<string_view> tokens;
+    for (int i = 0; i < 1'000'000; ++i) {
+        tokens.push_back(dictionary[uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)]);
+    }
+
+    // Прежняя схема: строка-ключ и её копия в words_in_docs_, ключ string_view в карте списков вхождений
+    using OldWords = map<string, pair<string, string_view>, less<>>;
+    OldWords old_words;
+    map<string_view, PostingList> old_postings;
+    {
+        LOG_DURATION("old words_in_docs_ ingestion"s);
+        for (const string_view token : tokens) {
+            string s_word(token);
+            if (old_words.count(s_word) == 0) {
+                old_words[s_word].first = s_word;
+                old_words.at(s_word).second = old_words.at(s_word).first;
+            }
+            old_postings[old_words.at(s_word).second];
+        }
+    }
+    TermDictionary terms;
+    vector<PostingList> postings;
+    {
+        LOG_DURATION("TermDictionary ingestion"s);
+        for (const string_view token : tokens) {
+            const int term_id = terms.Intern(token);
+            if (term_id == static_cast<int>(postings.size())) {
+                postings.emplace_back();
+            }
+        }
+    }
+
+    const auto heap_bytes = [](const string& str) {
+        // Короткие строки libstdc++ хранит внутри объекта
+        return str.size() > 15 ? str.capacity() + 1 : 0;
+    };
+    size_t old_bytes = 0;
+    for (const auto& [key, value] : old_words) {
+        old_bytes += RB_NODE_OVERHEAD + sizeof(OldWords::value_type) + heap_bytes(key) + heap_bytes(value.first);
+    }
+    old_bytes += old_postings.size() * (RB_NODE_OVERHEAD + sizeof(pair<const string_view, PostingList>));
+    const size_t new_bytes = terms.MemoryUsage() + postings.capacity() * sizeof(PostingList);
+
+    cerr << "terms: "s << terms.size() << endl;
+    cerr << "bytes per term before: "s << static_cast<double>(old_bytes) / old_words.size() << endl;
+    cerr << "bytes per term after: "s << static_cast<double>(new_bytes) / terms.size() << endl;
+}
+
+void BenchmarkInverseDocumentFreq() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    SearchServer search_server(dictionary[0]);
+    for (int i = 0; i < 20'000; ++i) {
+        search_server.AddDocument(i, GenerateQuery(generator, dictionary, 30), DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    // Горячая смесь: небольшой набор запросов повторяется много раз
+    const auto hot_queries = GenerateQueries(generator, dictionary, 20, 3);
+    vector<string_view> hot_words;
+    for (const auto& query : hot_queries) {
+        for (const auto word : SplitIntoWords(query)) {
+            hot_words.push_back(word);
+        }
+    }
+
+    map<string_view, size_t> document_freqs;
+    for (const int document_id : search_server) {
+        for (const auto& [word, term_freq] : search_server.GetWordFrequencies(document_id)) {
+            ++document_freqs[word];
+        }
+    }
+    vector<double> cached_idf;
+    for (const auto word : hot_words) {
+        const auto it = document_freqs.find(word);
+        cached_idf.push_back(it == document_freqs.end() ? 0.0 : log(search_server.GetDocumentCount() * 1.0 / it->second));
+    }
+
+    const int repeat_count = 100'000;
+    double checksum = 0;
+    {
+        LOG_DURATION("IDF: lookup + log per query term"s);
+        for (int i = 0; i < repeat_count; ++i) {
+            for (const auto word : hot_words) {
+                const auto it = document_freqs.find(word);
+                if (it != document_freqs.end()) {
+                    checksum += log(search_server.GetDocumentCount() * 1.0 / it->second);
+                }
+            }
+        }
+    }
+    {
+        LOG_DURATION("IDF: cached per term"s);
+        for (int i = 0; i < repeat_count; ++i) {
+            for (const double idf : cached_idf) {
+                checksum -= idf;
+            }
+        }
+    }
+    {
+        LOG_DURATION("FindTopDocuments: hot query mix"s);
+        for (int i = 0; i < 100; ++i) {
+            for (const auto& query : hot_queries) {
+                checksum += search_server.FindTopDocuments(query).size();
+            }
+        }
+    }
+    cerr << "checksum: "s << checksum << endl;
+}
+
+void BenchmarkQueryCache() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    SearchServer search_server(dictionary[0]);
+    for (int i = 0; i < 20'000; ++i) {
+        search_server.AddDocument(i, GenerateQuery(generator, dictionary, 30), DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    // Поток запросов с распределением Ципфа: вероятность k-го запроса пропорциональна 1/k
+    const auto distinct_queries = GenerateQueries(generator, dictionary, 10'000, 3);
+    vector<double> weights;
+    for (size_t rank = 1; rank <= distinct_queries.size(); ++rank) {
+        weights.push_back(1.0 / rank);
+    }
+    discrete_distribution<size_t> zipf(weights.begin(), weights.end());
+    vector<string_view> stream;
+    for (int i = 0; i < 20'000; ++i) {
+        stream.push_back(distinct_queries[zipf(generator)]);
+    }
+
+    size_t checksum = 0;
+    {
+        LOG_DURATION("Zipfian stream without cache"s);
+        for (const auto query : stream) {
+            checksum += search_server.FindTopDocuments(query).size();
+        }
+    }
+    search_server.EnableQueryCache(1'000);
+    {
+        LOG_DURATION("Zipfian stream with cache"s);
+        for (const auto query : stream) {
+            checksum -= search_server.FindTopDocuments(query).size();
+        }
+    }
+    const auto stats = search_server.GetQueryCacheStats();
+    cerr << "hits: "s << stats.hits << ", misses: "s << stats.misses << ", evictions: "s << stats.evictions << endl;
+    if (checksum != 0) {
+        cerr << "cached results differ"s << endl;
+    }
+}
+
+void BenchmarkTokenizer() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 10'000, 12);
+    string text;
+    while (text.size() < 64 * 1024 * 1024) {
+        text += dictionary[uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)];
+        text.push_back(' ');
+    }
+    const double megabytes = text.size() / (1024.0 * 1024.0);
+    vector<string_view> words;
+    words.reserve(text.size() / 4);
+
+    const auto report = [megabytes](const string& name, chrono::steady_clock::duration duration) {
+        const double seconds = chrono::duration<double>(duration).count();
+        cerr << name << ": "s << megabytes / seconds << " MB/s"s << endl;
+    };
+
+    // Прежний путь: find(' ') в цикле и отдельная проверка каждого слова
+    auto start = chrono::steady_clock::now();
+    size_t invalid_words = 0;
+    for (const auto word : SplitIntoWords(text)) {
+        invalid_words += any_of(word.begin(), word.end(), [](char c) { return c >= '\0' && c < ' '; });
+    }
+    report("find + IsValidWord"s, chrono::steady_clock::now() - start);
+
+    for (const SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2}) {
+        if (!IsSimdLevelSupported(level)) {
+            continue;
+        }
+        start = chrono::steady_clock::now();
+        invalid_words += SplitIntoWordsChecked(level, text, words) != string_view::npos;
+        report("SplitIntoWordsChecked level "s + to_string(static_cast<int>(level)), chrono::steady_clock::now() - start);
+    }
+    if (invalid_words != 0) {
+        cerr << "unexpected invalid words"s << endl;
+    }
+}
+
+void BenchmarkProcessQueriesStream() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    SearchServer search_server(dictionary[0]);
+    for (int i = 0; i < 10'000; ++i) {
+        search_server.AddDocument(i, GenerateQuery(generator, dictionary, 50), DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    const auto queries = GenerateQueries(generator, dictionary, 20'000, 7);
+
+    size_t batch_documents = 0;
+    {
+        LOG_DURATION("ProcessQueries (whole batch in memory)"s);
+        for (const auto& documents : ProcessQueries(search_server, queries)) {
+            batch_documents += documents.size();
+        }
+    }
+    size_t stream_documents = 0;
+    {
+        LOG_DURATION("ProcessQueriesStream"s);
+        ProcessQueriesStream(search_server, queries.begin(), queries.end(), [&stream_documents](size_t, const vector<Document>& documents) {
+            stream_documents += documents.size();
+        });
+    }
+    // Пакет держит в памяти результаты всех запросов сразу, поток - не больше глубины конвейера
+    cerr << "batch results held: "s << queries.size() << ", stream results held: "s
+         << 4 * max(1u, thread::hardware_concurrency()) << endl;
+    if (batch_documents != stream_documents) {
+        cerr << "stream results differ"s << endl;
+    }
+}
+
+void BenchmarkQueryExecutor() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 10'000, 10);
+    // Первые 20 слов словаря частые: встречаются почти в каждом документе
+    const vector<string> common_words(dictionary.begin(), dictionary.begin() + 20);
+    SearchServer search_server(""s);
+    for (int i = 0; i < 20'000; ++i) {
+        search_server.AddDocument(i, GenerateQuery(generator, common_words, 10) + " "s + GenerateQuery(generator, dictionary, 20), DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    // Смесь запросов: 95% по одному редкому слову, 5% из пяти частых слов
+    vector<vector<string>> batches(200);
+    bernoulli_distribution heavy(0.05);
+    for (auto& batch : batches) {
+        for (int i = 0; i < 64; ++i) {
+            batch.push_back(heavy(generator) ? GenerateQuery(generator, common_words, 5) : GenerateQuery(generator, dictionary, 1));
+        }
+    }
+
+    const auto report = [](const string& name, vector<double> latencies) {
+        sort(latencies.begin(), latencies.end());
+        cerr << name << ": p50 "s << latencies[latencies.size() / 2] << " ms, p99 "s << latencies[latencies.size() * 99 / 100]
+             << " ms, max "s << latencies.back() << " ms"s << endl;
+    };
+    const auto measure = [&batches](auto process) {
+        vector<double> latencies;
+        for (const auto& batch : batches) {
+            const auto start = chrono::steady_clock::now();
+            process(batch);
+            latencies.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+        }
+        return latencies;
+    };
+
+    report("std::execution::par batch latency"s, measure([&search_server](const vector<string>& batch) {
+        ProcessQueries(search_server, batch);
+    }));
+    QueryExecutor executor;
+    report("QueryExecutor batch latency"s, measure([&search_server, &executor](const vector<string>& batch) {
+        ProcessQueries(executor, search_server, batch);
+    }));
+    const auto stats = executor.GetWorkerStats();
+    for (size_t worker = 0; worker < stats.size(); ++worker) {
+        cerr << "worker "s << worker << ": tasks "s << stats[worker].executed_tasks << ", stolen "s << stats[worker].stolen_tasks
+             << ", busy "s << chrono::duration_cast<chrono::milliseconds>(stats[worker].busy_time).count() << " ms"s << endl;
+    }
+}
+
+void BenchmarkSegmentedIngest() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 5'000, 10);
+    vector<string> documents;
+    for (int i = 0; i < 100'000; ++i) {
+        documents.push_back(GenerateQuery(generator, dictionary, 30));
+    }
+    const auto queries = GenerateQueries(generator, dictionary, 1'000, 3);
+
+    // Писатель добавляет все документы, читатель в это время непрерывно выполняет запросы
+    const auto run = [&documents, &queries](const string& name, auto add_document, auto find_top_documents) {
+        atomic<bool> ingesting = true;
+        vector<double> latencies;
+        thread reader([&] {
+            for (size_t i = 0; ingesting; ++i) {
+                const auto start = chrono::steady_clock::now();
+                find_top_documents(queries[i % queries.size()]);
+                latencies.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+            }
+        });
+        const auto start = chrono::steady_clock::now();
+        for (int id = 0; id < static_cast<int>(documents.size()); ++id) {
+            add_document(id, documents[id]);
+        }
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        ingesting = false;
+        reader.join();
+        sort(latencies.begin(), latencies.end());
+        cerr << name << ": ingest "s << static_cast<int>(documents.size() / seconds) << " docs/s, "s << latencies.size() << " queries, p50 "s
+             << latencies[latencies.size() / 2] << " ms, p99 "s << latencies[latencies.size() * 99 / 100] << " ms"s << endl;
+    };
+
+    {
+        SearchServer search_server(dictionary[0]);
+        shared_mutex mutex;
+        run("SearchServer + shared_mutex"s, [&](int id, const string& document) {
+            unique_lock lock(mutex);
+            search_server.AddDocument(id, document, DocumentStatus::ACTUAL, {1, 2, 3});
+        }, [&](const string& query) {
+            shared_lock lock(mutex);
+            return search_server.FindTopDocuments(query);
+        });
+    }
+    {
+        SegmentedSearchServer search_server(vector<string>{dictionary[0]});
+        run("SegmentedSearchServer"s, [&](int id, const string& document) {
+            search_server.AddDocument(id, document, DocumentStatus::ACTUAL, {1, 2, 3});
+        }, [&](const string& query) {
+            return search_server.FindTopDocuments(query);
+        });
+        search_server.WaitForMerges();
+        cerr << "segments after ingest: "s << search_server.GetSegmentCount() << endl;
+
+        // Запрос с одним вхождением: стоимость не должна зависеть от размера сегментов
+        search_server.AddDocument(static_cast<int>(documents.size()), "rare"s, DocumentStatus::ACTUAL, {1});
+        search_server.Flush();
+        size_t total = 0;
+        {
+            LOG_DURATION("SegmentedSearchServer, one posting x10000"s);
+            for (int i = 0; i < 10'000; ++i) {
+                total += search_server.FindTopDocuments("rare"s).size();
+            }
+        }
+        cerr << "results: "s << total << endl;
+    }
+}
+
+void BenchmarkDeferredRemoval() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 10);
+    SearchServer immediate_server(dictionary[0]);
+    for (int i = 0; i < 50'000; ++i) {
+        immediate_server.AddDocument(i, GenerateQuery(generator, dictionary, 50), DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    SearchServer deferred_server(immediate_server);
+    deferred_server.SetDeferredRemoval(true);
+
+    {
+        LOG_DURATION("RemoveDocument x 10000 (immediate)"s);
+        for (int i = 0; i < 50'000; i += 5) {
+            immediate_server.RemoveDocument(i);
+        }
+    }
+    {
+        LOG_DURATION("RemoveDocument x 10000 (deferred)"s);
+        for (int i = 0; i < 50'000; i += 5) {
+            deferred_server.RemoveDocument(i);
+        }
+    }
+    {
+        LOG_DURATION("Compact"s);
+        deferred_server.Compact();
+    }
+    if (immediate_server.FindTopDocuments(dictionary[1]).size() != deferred_server.FindTopDocuments(dictionary[1]).size()) {
+        cerr << "deferred removal results differ"s << endl;
+    }
+}
+
+void BenchmarkFindDuplicates() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 10);
+    const double duplicate_ratio = 0.3;
+    SearchServer search_server(dictionary[0]);
+    vector<string> originals;
+    bernoulli_distribution is_duplicate(duplicate_ratio);
+    size_t expected_duplicates = 0;
+    for (int id = 0; id < 100'000; ++id) {
+        if (!originals.empty() && is_duplicate(generator)) {
+            // Дубликат: слова случайного исходного документа в обратном порядке
+            const string& original = originals[uniform_int_distribution<size_t>(0, originals.size() - 1)(generator)];
+            auto words = SplitIntoWords(original);
+            reverse(words.begin(), words.end());
+            string text;
+            for (const auto word : words) {
+                if (!text.empty()) {
+                    text.push_back(' ');
+                }
+                text += word;
+            }
+            search_server.AddDocument(id, text, DocumentStatus::ACTUAL, {1});
+            ++expected_duplicates;
+        } else {
+            originals.push_back(GenerateQuery(generator, dictionary, 30));
+            search_server.AddDocument(id, originals.back(), DocumentStatus::ACTUAL, {1});
+        }
+    }
+
+    vector<int> set_duplicates;
+    {
+        LOG_DURATION("set<set<string>> duplicates"s);
+        set<set<string>> words_in_docs;
+        for (const int document_id : search_server) {
+            set<string> words;
+            for (const auto& [word, freq] : search_server.GetWordFrequencies(document_id)) {
+                words.insert(string(word));
+            }
+            if (!words_in_docs.insert(move(words)).second) {
+                set_duplicates.push_back(document_id);
+            }
+        }
+    }
+    vector<int> fingerprint_duplicates;
+    {
+        LOG_DURATION("FindDuplicates (fingerprints)"s);
+        fingerprint_duplicates = FindDuplicates(search_server);
+    }
+    cerr << "duplicates: "s << fingerprint_duplicates.size() << " of "s << expected_duplicates << " generated"s << endl;
+    if (set_duplicates != fingerprint_duplicates) {
+        cerr << "duplicate lists differ"s << endl;
+    }
+}
+
+void BenchmarkFindNearDuplicates() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 20'000, 10);
+    // 20% документов - копии других с одним-двумя заменёнными словами (Жаккар >= 0.87)
+    const auto make_corpus = [&](int document_count) {
+        SearchServer search_server(""s);
+        vector<vector<string>> originals;
+        size_t near_duplicates = 0;
+        bernoulli_distribution is_near_duplicate(0.2);
+        for (int id = 0; id < document_count; ++id) {
+            vector<string> words;
+            if (!originals.empty() && is_near_duplicate(generator)) {
+                words = originals[uniform_int_distribution<size_t>(0, originals.size() - 1)(generator)];
+                for (int i = uniform_int_distribution(1, 2)(generator); i > 0; --i) {
+                    words[uniform_int_distribution<size_t>(0, words.size() - 1)(generator)] = GenerateWord(generator, 12) + "x"s;
+                }
+                ++near_duplicates;
+            } else {
+                for (int i = 0; i < 30; ++i) {
+                    words.push_back(dictionary[uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)]);
+                }
+                sort(words.begin(), words.end());
+                words.erase(unique(words.begin(), words.end()), words.end());
+                originals.push_back(words);
+            }
+            string text;
+            for (const string& word : words) {
+                text += word + " "s;
+            }
+            text.pop_back();
+            search_server.AddDocument(id, text, DocumentStatus::ACTUAL, {1});
+        }
+        return make_pair(move(search_server), near_duplicates);
+    };
+    const auto count_duplicates = [](const vector<vector<int>>& clusters) {
+        size_t count = 0;
+        for (const auto& cluster : clusters) {
+            count += cluster.size() - 1;
+        }
+        return count;
+    };
+
+    {
+        const auto [search_server, near_duplicates] = make_corpus(2'000);
+        size_t brute_force_pairs = 0;
+        {
+            LOG_DURATION("all pairs Jaccard, 2000 documents"s);
+            const vector<int> ids(search_server.begin(), search_server.end());
+            for (size_t i = 0; i < ids.size(); ++i) {
+                const auto& lhs = search_server.GetWordFrequencies(ids[i]);
+                for (size_t j = i + 1; j < ids.size(); ++j) {
+                    const auto& rhs = search_server.GetWordFrequencies(ids[j]);
+                    size_t common = 0;
+                    for (const auto& [word, freq] : lhs) {
+                        common += rhs.count(word);
+                    }
+                    brute_force_pairs += common * 5 >= (lhs.size() + rhs.size() - common) * 4;
+                }
+            }
+        }
+        vector<vector<int>> clusters;
+        {
+            LOG_DURATION("FindNearDuplicates, 2000 documents"s);
+            clusters = FindNearDuplicates(search_server, 0.8);
+        }
+        cerr << "generated "s << near_duplicates << ", found "s << count_duplicates(clusters) << ", similar pairs "s << brute_force_pairs << endl;
+    }
+    {
+        const auto [search_server, near_duplicates] = make_corpus(100'000);
+        vector<vector<int>> clusters;
+        {
+            LOG_DURATION("FindNearDuplicates, 100000 documents"s);
+            clusters = FindNearDuplicates(search_server, 0.8);
+        }
+        cerr << "generated "s << near_duplicates << ", found "s << count_duplicates(clusters) << endl;
+    }
+}
+
+void BenchmarkConjunctiveQueries() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    SearchServer search_server(""s);
+    for (int i = 0; i < 50'000; ++i) {
+        search_server.AddDocument(i, GenerateQuery(generator, dictionary, 40), DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    vector<string> queries;
+    for (int i = 0; i < 200; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, uniform_int_distribution(2, 3)(generator)));
+    }
+
+    size_t filtered_count = 0;
+    {
+        LOG_DURATION("ANY + MatchDocument filter"s);
+        for (const string& query : queries) {
+            const vector<string_view> words = SplitIntoWords(query);
+            const size_t plus_word_count = set<string_view>(words.begin(), words.end()).size();
+            vector<Document> documents;
+            for (const Document& document : search_server.FindTopDocuments(query, DocumentStatus::ACTUAL, numeric_limits<size_t>::max())) {
+                if (get<0>(search_server.MatchDocument(query, document.id)).size() == plus_word_count) {
+                    documents.push_back(document);
+                }
+            }
+            filtered_count += min<size_t>(documents.size(), MAX_RESULT_DOCUMENT_COUNT);
+        }
+    }
+    size_t conjunctive_count = 0;
+    {
+        LOG_DURATION("QueryMode::ALL"s);
+        for (const string& query : queries) {
+            conjunctive_count += search_server.FindTopDocuments(QueryMode::ALL, query).size();
+        }
+    }
+    if (filtered_count != conjunctive_count) {
+        cerr << "conjunctive results differ"s << endl;
+    }
+}
+
+void BenchmarkPrunedQueries() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    // Частоты слов по закону Ципфа: у частых слов длинные списки вхождений
+    vector<double> weights(dictionary.size());
+    for (size_t i = 0; i < weights.size(); ++i) {
+        weights[i] = 1.0 / (i + 1);
+    }
+    discrete_distribution<size_t> zipf(weights.begin(), weights.end());
+    const auto generate_text = [&](int word_count) {
+        string text;
+        for (int i = 0; i < word_count; ++i) {
+            text += (i == 0 ? ""s : " "s) + dictionary[zipf(generator)];
+        }
+        return text;
+    };
+    SearchServer search_server(""s);
+    for (int i = 0; i < 100'000; ++i) {
+        search_server.AddDocument(i, generate_text(uniform_int_distribution(10, 60)(generator)), DocumentStatus::ACTUAL, {i % 10});
+    }
+    vector<string> queries;
+    for (int i = 0; i < 200; ++i) {
+        queries.push_back(generate_text(uniform_int_distribution(3, 6)(generator)));
+    }
+
+    size_t mismatch_count = 0;
+    vector<vector<Document>> exhaustive;
+    {
+        LOG_DURATION("ANY exhaustive"s);
+        for (const string& query : queries) {
+            exhaustive.push_back(search_server.FindTopDocuments(query));
+        }
+    }
+    {
+        LOG_DURATION("ANY_PRUNED (MaxScore)"s);
+        for (size_t i = 0; i < queries.size(); ++i) {
+            const auto pruned = search_server.FindTopDocuments(QueryMode::ANY_PRUNED, queries[i]);
+            // Среди документов с равными релевантностью и рейтингом порядок не определён, сверяем их значения
+            mismatch_count += !equal(pruned.begin(), pruned.end(), exhaustive[i].begin(), exhaustive[i].end(), [](const Document& lhs, const Document& rhs) {
+                return lhs.relevance == rhs.relevance && lhs.rating == rhs.rating;
+            });
+        }
+    }
+    if (mismatch_count > 0) {
+        cerr << "pruned results differ: "s << mismatch_count << endl;
+    }
+}
+
+void BenchmarkMinusWords() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    SearchServer search_server(""s);
+    // Слова common* есть в большой доле документов: у минус-слов длинные списки вхождений
+    for (int i = 0; i < 100'000; ++i) {
+        string text = GenerateQuery(generator, dictionary, 20);
+        for (const string& word : {"common_a"s, "common_b"s, "common_c"s}) {
+            if (uniform_int_distribution(0, 2)(generator) > 0) {
+                text += " "s + word;
+            }
+        }
+        search_server.AddDocument(i, text, DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    const string query = "common_a -common_b -common_c"s;
+    {
+        LOG_DURATION("minus words, seq"s);
+        for (int i = 0; i < 20; ++i) {
+            search_server.FindTopDocuments(query);
+        }
+    }
+    {
+        LOG_DURATION("minus words, par"s);
+        for (int i = 0; i < 20; ++i) {
+            search_server.FindTopDocuments(execution::par, query);
+        }
+    }
+    {
+        LOG_DURATION("minus words, QueryContext"s);
+        QueryContext context;
+        for (int i = 0; i < 20; ++i) {
+            search_server.FindTopDocuments(context, query);
+        }
+    }
+}
+
+void BenchmarkCompressedPostings() {
+    using namespace chrono;
+    mt19937 generator;
+    const int document_count = 1'000'000;
+    vector<double> inv_document_lengths(document_count);
+    for (double& inv_length : inv_document_lengths) {
+        inv_length = 1.0 / uniform_int_distribution(10, 200)(generator);
+    }
+    // Списки разной плотности, всего около 10 млн вхождений
+    vector<PostingList> postings;
+    vector<CompressedPostingList> compressed;
+    size_t posting_count = 0;
+    size_t plain_bytes = 0;
+    size_t compressed_bytes = 0;
+    for (int list = 0; list < 100; ++list) {
+        const double density = min(0.9, 2.0 / (list + 1));
+        bernoulli_distribution contains(density);
+        geometric_distribution<uint32_t> extra_count(0.7);
+        vector<int> document_ids;
+        vector<uint32_t> term_counts;
+        vector<Relevance> term_freqs;
+        for (int document_id = 0; document_id < document_count; ++document_id) {
+            if (contains(generator)) {
+                document_ids.push_back(document_id);
+                term_counts.push_back(1 + extra_count(generator));
+                term_freqs.push_back(term_counts.back() * inv_document_lengths[document_id]);
+            }
+        }
+        postings.emplace_back(document_ids.data(), term_freqs.data(), document_ids.size());
+        compressed.emplace_back(document_ids, term_counts);
+        posting_count += document_ids.size();
+        plain_bytes += postings.back().MemoryUsage();
+        compressed_bytes += compressed.back().MemoryUsage();
+    }
+    cerr << "postings: "s << posting_count << endl;
+    cerr << "PostingList: "s << static_cast<double>(plain_bytes) / posting_count << " bytes per posting"s << endl;
+    cerr << "CompressedPostingList: "s << static_cast<double>(compressed_bytes) / posting_count << " bytes per posting"s << endl;
+
+    for (const SimdLevel level : {SimdLevel::SCALAR, GetBestSimdLevel()}) {
+        const auto start = steady_clock::now();
+        uint64_t checksum = 0;
+        for (const auto& list : compressed) {
+            for (CompressedPostingCursor cursor(list, level); cursor.IsValid(); cursor.Next()) {
+                checksum += cursor.GetDocumentId() + cursor.GetTermCount();
+            }
+        }
+        const double seconds = duration<double>(steady_clock::now() - start).count();
+        cerr << "decode, level "s << static_cast<int>(level) << ": "s << posting_count / seconds / 1e6 << " M postings/s (checksum "s << checksum % 1000 << ")"s << endl;
+    }
+
+    // Подсчёт релевантности с распаковкой на лету против несжатых списков
+    vector<double> scores(document_count);
+    {
+        LOG_DURATION("score PostingList"s);
+        for (const auto& list : postings) {
+            const auto& document_ids = list.GetDocumentIds();
+            const auto& term_freqs = list.GetTermFreqs();
+            for (size_t i = 0; i < document_ids.size(); ++i) {
+                scores[document_ids[i]] += term_freqs[i] * 1.5;
+            }
+        }
+    }
+    {
+        LOG_DURATION("score CompressedPostingList"s);
+        int document_ids[CompressedPostingList::BLOCK_SIZE];
+        uint32_t term_counts[CompressedPostingList::BLOCK_SIZE];
+        for (const auto& list : compressed) {
+            for (size_t block = 0; block < list.GetBlockCount(); ++block) {
+                const size_t count = list.DecodeBlock(block, document_ids, term_counts);
+                for (size_t i = 0; i < count; ++i) {
+                    scores[document_ids[i]] -= term_counts[i] * inv_document_lengths[document_ids[i]] * 1.5;
+                }
+            }
+        }
+    }
+    // Оба прохода дают одни и те же вклады, поэтому сумма близка к нулю
+    cerr << "score difference: "s << *max_element(scores.begin(), scores.end()) << endl;
+
+    // Сегмент SegmentedSearchServer: несжатый индекс против FrozenSegment
+    SearchServer search_server(""s);
+    const auto dictionary = GenerateDictionary(generator, 10'000, 10);
+    for (int id = 0; id < 100'000; ++id) {
+        search_server.AddDocument(id, GenerateQuery(generator, dictionary, 50), DocumentStatus::ACTUAL, {1});
+    }
+    const FrozenSegment segment(search_server);
+    cerr << "SearchServer: "s << search_server.MemoryUsage() / 100'000.0 << " bytes per document"s << endl;
+    cerr << "FrozenSegment: "s << segment.MemoryUsage() / 100'000.0 << " bytes per document"s << endl;
+    const auto queries = GenerateQueries(generator, dictionary, 1'000, 10);
+    vector<CorpusStatistics> statistics(queries.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        search_server.CollectStatistics(queries[i], statistics[i]);
+    }
+    size_t total = 0;
+    const auto predicate = [](int, DocumentStatus, int) {
+        return true;
+    };
+    {
+        LOG_DURATION("segment queries, SearchServer"s);
+        for (size_t i = 0; i < queries.size(); ++i) {
+            total += search_server.FindTopDocuments(statistics[i], queries[i], predicate).size();
+        }
+    }
+    // Запросы сгенерированы без минус-слов и стоп-слов: плюс-слова - это ключи статистики
+    vector<vector<string_view>> plus_words(queries.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        for (const auto& [word, document_freq] : statistics[i].document_freqs) {
+            plus_words[i].push_back(word);
+        }
+    }
+    {
+        LOG_DURATION("segment queries, FrozenSegment"s);
+        for (size_t i = 0; i < queries.size(); ++i) {
+            total -= segment.FindTopDocuments(statistics[i], plus_words[i], {}, predicate, MAX_RESULT_DOCUMENT_COUNT).size();
+        }
+    }
+    cerr << "result count difference: "s << total << endl;
+}
+
+void BenchmarkForwardIndex() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 10'000, 10);
+    SearchServer search_server(""s);
+    const int document_count = 100'000;
+    for (int i = 0; i < document_count; ++i) {
+        search_server.AddDocument(i, GenerateQuery(generator, dictionary, 50), DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    // Прежняя схема: у каждого документа своё дерево std::map<std::string_view, double>
+    using OldDocumentWords = map<string_view, double>;
+    vector<OldDocumentWords> old_index(document_count);
+    TermDictionary terms;
+    ForwardIndex forward_index;
+    for (int i = 0; i < document_count; ++i) {
+        forward_index.AddDocument();
+        for (const auto& [word, term_freq] : search_server.GetWordFrequencies(i)) {
+            old_index[i].emplace_hint(old_index[i].end(), word, term_freq);
+            forward_index.AddTerm(terms.Intern(word), term_freq);
+        }
+    }
+    size_t old_bytes = old_index.capacity() * sizeof(OldDocumentWords);
+    size_t entry_count = 0;
+    for (const auto& document_words : old_index) {
+        old_bytes += document_words.size() * (RB_NODE_OVERHEAD + sizeof(OldDocumentWords::value_type));
+        entry_count += document_words.size();
+    }
+    const size_t new_bytes = forward_index.MemoryUsage();
+    cerr << "words per document: "s << static_cast<double>(entry_count) / document_count << endl;
+    cerr << "map forward index: "s << static_cast<double>(old_bytes) / document_count << " bytes per document"s << endl;
+    cerr << "ForwardIndex: "s << static_cast<double>(new_bytes) / document_count << " bytes per document"s << endl;
+
+    double checksum = 0.0;
+    {
+        LOG_DURATION("iterate map forward index"s);
+        for (const auto& document_words : old_index) {
+            for (const auto& [word, term_freq] : document_words) {
+                checksum += term_freq * word.size();
+            }
+        }
+    }
+    {
+        LOG_DURATION("iterate GetWordFrequencies"s);
+        for (int i = 0; i < document_count; ++i) {
+            for (const auto& [word, term_freq] : search_server.GetWordFrequencies(i)) {
+                checksum -= term_freq * word.size();
+            }
+        }
+    }
+    cerr << "checksum: "s << checksum << endl;
+}
+
+void BenchmarkScoringKernel() {
+    using namespace chrono;
+    mt19937 generator;
+    const int document_count = 1'000'000;
+    // Списки разной плотности, всего около 10 млн вхождений
+    vector<vector<int>> document_ids(100);
+    vector<vector<Relevance>> term_freqs(100);
+    size_t posting_count = 0;
+    for (int list = 0; list < 100; ++list) {
+        bernoulli_distribution contains(min(0.9, 2.0 / (list + 1)));
+        for (int document_id = 0; document_id < document_count; ++document_id) {
+            if (contains(generator)) {
+                document_ids[list].push_back(document_id);
+                term_freqs[list].push_back(static_cast<Relevance>(1.0 / uniform_int_distribution(10, 200)(generator)));
+            }
+        }
+        posting_count += document_ids[list].size();
+    }
+    cerr << "postings: "s << posting_count << endl;
+    for (const SimdLevel level : {SimdLevel::SCALAR, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (!IsSimdLevelSupported(level)) {
+            continue;
+        }
+        vector<Relevance> scores(document_count);
+        const auto start = steady_clock::now();
+        for (int list = 0; list < 100; ++list) {
+            for (size_t first = 0; first < document_ids[list].size(); first += SCORING_BLOCK_SIZE) {
+                const size_t count = min(SCORING_BLOCK_SIZE, document_ids[list].size() - first);
+                AccumulateScores(level, document_ids[list].data() + first, term_freqs[list].data() + first, count, static_cast<Relevance>(list + 1), scores.data());
+            }
+        }
+        const double seconds = duration<double>(steady_clock::now() - start).count();
+        cerr << "accumulate, level "s << static_cast<int>(level) << ": "s << posting_count / seconds / 1e6 << " M postings/s (checksum "s << accumulate(scores.begin(), scores.end(), 0.0) << ")"s << endl;
+    }
+
+    // Поиск с QueryContext: подсчёт через ядро
+    SearchServer search_server(""s);
+    const auto dictionary = GenerateDictionary(generator, 1000, 10);
+    for (int id = 0; id < 100'000; ++id) {
+        search_server.AddDocument(id, GenerateQuery(generator, dictionary, 50), DocumentStatus::ACTUAL, {1});
+    }
+    const auto queries = GenerateQueries(generator, dictionary, 1'000, 10);
+    QueryContext context;
+    size_t total = 0;
+    {
+        LOG_DURATION("QueryContext queries"s);
+        for (const string& query : queries) {
+            total += search_server.FindTopDocuments(context, query).size();
+        }
+    }
+    {
+        LOG_DURATION("seq queries"s);
+        for (const string& query : queries) {
+            total -= search_server.FindTopDocuments(query).size();
+        }
+    }
+    cerr << "results: "s << total << " (0 if seq queries agree)"s << endl;
+
+    // Запрос с одним вхождением: стоимость не должна зависеть от числа документов
+    search_server.AddDocument(100'000, "rare"s, DocumentStatus::ACTUAL, {1});
+    size_t rare_total = 0;
+    {
+        LOG_DURATION("seq queries, one posting x10000"s);
+        for (int i = 0; i < 10'000; ++i) {
+            rare_total += search_server.FindTopDocuments("rare"s).size();
+        }
+    }
+    cerr << "results: "s << rare_total << endl;
+}
+
+void RunBenchmarks() {
+    BenchmarkPostingLists();
+    BenchmarkTopDocuments();
+    BenchmarkRelevanceAccumulation();
+    BenchmarkAddDocuments();
+    BenchmarkSnapshotLoad();
+    BenchmarkTermDictionary();
+    BenchmarkInverseDocumentFreq();
+    BenchmarkQueryCache();
+    BenchmarkTokenizer();
+    BenchmarkProcessQueriesStream();
+    BenchmarkQueryExecutor();
+    BenchmarkSegmentedIngest();
+    BenchmarkDeferredRemoval();
+    BenchmarkFindDuplicates();
+    BenchmarkFindNearDuplicates();
+    BenchmarkConjunctiveQueries();
+    BenchmarkPrunedQueries();
+    BenchmarkMinusWords();
+    BenchmarkCompressedPostings();
+    BenchmarkForwardIndex();
+    BenchmarkScoringKernel();
+}
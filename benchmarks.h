@@ -0,0 +1,45 @@
+#pragma once
+
+void BenchmarkPostingLists();
+
+void BenchmarkTopDocuments();
+
+void BenchmarkRelevanceAccumulation();
+
+void BenchmarkAddDocuments();
+
+void BenchmarkSnapshotLoad();
+
+void BenchmarkTermDictionary();
+
+void BenchmarkInverseDocumentFreq();
+
+void BenchmarkQueryCache();
+
+void BenchmarkTokenizer();
+
+void BenchmarkProcessQueriesStream();
+
+void BenchmarkQueryExecutor();
+
+void BenchmarkSegmentedIngest();
+
+void BenchmarkDeferredRemoval();
+
+void BenchmarkFindDuplicates();
+
+void BenchmarkFindNearDuplicates();
+
+void BenchmarkConjunctiveQueries();
+
+void BenchmarkPrunedQueries();
+
+void BenchmarkMinusWords();
+
+void BenchmarkCompressedPostings();
+
+void BenchmarkForwardIndex();
+
+void BenchmarkScoringKernel();
+
+void RunBenchmarks();
@@ -0,0 +1,183 @@
+#include "compressed_posting_list.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Запас в конце данных для чтения по 16 байт
+constexpr size_t DATA_PADDING = 16;
+
+size_t GetEncodedLength(uint32_t value) {
+    return value < (1u << 8) ? 1 : value < (1u << 16) ? 2 : value < (1u << 24) ? 3 : 4;
+}
+
+void EncodeStreamVByte(const uint32_t* values, size_t count, std::vector<uint8_t>& out) {
+    const size_t control_pos = out.size();
+    out.resize(out.size() + (count + 3) / 4, 0);
+    for (size_t i = 0; i < count; ++i) {
+        const size_t length = GetEncodedLength(values[i]);
+        out[control_pos + i / 4] |= static_cast<uint8_t>((length - 1) << (2 * (i % 4)));
+        for (size_t byte = 0; byte < length; ++byte) {
+            out.push_back(static_cast<uint8_t>(values[i] >> (8 * byte)));
+        }
+    }
+}
+
+// Суммарная длина значений по управляющему байту
+const std::array<uint8_t, 256> CONTROL_LENGTHS = [] {
+    std::array<uint8_t, 256> lengths{};
+    for (size_t control = 0; control < 256; ++control) {
+        for (size_t i = 0; i < 4; ++i) {
+            lengths[control] += static_cast<uint8_t>(((control >> (2 * i)) & 3) + 1);
+        }
+    }
+    return lengths;
+}();
+
+// Распаковка count значений; возвращает конец байтов значений
+using DecodeFunction = const uint8_t* (*)(const uint8_t* in, size_t count, uint32_t* out);
+
+const uint8_t* DecodeStreamVByteScalar(const uint8_t* in, size_t count, uint32_t* out) {
+    const uint8_t* control = in;
+    const uint8_t* data = in + (count + 3) / 4;
+    for (size_t i = 0; i < count; ++i) {
+        const size_t length = ((control[i / 4] >> (2 * (i % 4))) & 3) + 1;
+        uint32_t value = 0;
+        for (size_t byte = 0; byte < length; ++byte) {
+            value |= static_cast<uint32_t>(data[byte]) << (8 * byte);
+        }
+        out[i] = value;
+        data += length;
+    }
+    return data;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Маски перестановки: байты четырёх значений раскладываются по 32-битным словам, 0x80 - ноль
+const std::array<std::array<uint8_t, 16>, 256> SHUFFLE_MASKS = [] {
+    std::array<std::array<uint8_t, 16>, 256> masks{};
+    for (size_t control = 0; control < 256; ++control) {
+        uint8_t source = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            const size_t length = ((control >> (2 * i)) & 3) + 1;
+            for (size_t byte = 0; byte < 4; ++byte) {
+                masks[control][4 * i + byte] = byte < length ? source++ : 0x80;
+            }
+        }
+    }
+    return masks;
+}();
+
+// pshufb (SSSE3) есть на всех процессорах с AVX2
+__attribute__((target("avx2")))
+const uint8_t* DecodeStreamVByteAvx2(const uint8_t* in, size_t count, uint32_t* out) {
+    const uint8_t* control = in;
+    const uint8_t* data = in + (count + 3) / 4;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const uint8_t code = control[i / 4];
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(SHUFFLE_MASKS[code].data()));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_shuffle_epi8(bytes, mask));
+        data += CONTROL_LENGTHS[code];
+    }
+    for (; i < count; ++i) {
+        const size_t length = ((control[i / 4] >> (2 * (i % 4))) & 3) + 1;
+        uint32_t value = 0;
+        for (size_t byte = 0; byte < length; ++byte) {
+            value |= static_cast<uint32_t>(data[byte]) << (8 * byte);
+        }
+        out[i] = value;
+        data += length;
+    }
+    return data;
+}
+
+#endif
+
+DecodeFunction GetDecodeFunction(SimdLevel level) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (level >= SimdLevel::AVX2 && IsSimdLevelSupported(SimdLevel::AVX2)) {
+        return DecodeStreamVByteAvx2;
+    }
+#endif
+    return DecodeStreamVByteScalar;
+}
+
+} // namespace
+
+CompressedPostingList::CompressedPostingList(const std::vector<int>& document_ids, const std::vector<uint32_t>& term_counts)
+    : size_(document_ids.size())
+{
+    uint32_t values[BLOCK_SIZE];
+    int previous_id = 0;
+    for (size_t first = 0; first < document_ids.size(); first += BLOCK_SIZE) {
+        const size_t count = std::min(BLOCK_SIZE, document_ids.size() - first);
+        blocks_.push_back({document_ids[first + count - 1], static_cast<uint32_t>(data_.size())});
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = static_cast<uint32_t>(document_ids[first + i] - previous_id);
+            previous_id = document_ids[first + i];
+        }
+        EncodeStreamVByte(values, count, data_);
+        EncodeStreamVByte(term_counts.data() + first, count, data_);
+    }
+    data_.resize(data_.size() + DATA_PADDING, 0);
+    data_.shrink_to_fit();
+}
+
+size_t CompressedPostingList::DecodeBlock(size_t block, int* document_ids, uint32_t* term_counts, SimdLevel level) const
+{
+    static const DecodeFunction best_decode = GetDecodeFunction(GetBestSimdLevel());
+    const DecodeFunction decode = level == GetBestSimdLevel() ? best_decode : GetDecodeFunction(level);
+
+    const size_t count = std::min(BLOCK_SIZE, size_ - block * BLOCK_SIZE);
+    uint32_t* deltas = reinterpret_cast<uint32_t*>(document_ids);
+    const uint8_t* counts_begin = decode(data_.data() + blocks_[block].offset, count, deltas);
+    decode(counts_begin, count, term_counts);
+    // Разности в id: первая отсчитывается от последнего id предыдущего блока
+    uint32_t document_id = block == 0 ? 0 : static_cast<uint32_t>(blocks_[block - 1].last_document_id);
+    for (size_t i = 0; i < count; ++i) {
+        document_id += deltas[i];
+        document_ids[i] = static_cast<int>(document_id);
+    }
+    return count;
+}
+
+CompressedPostingCursor::CompressedPostingCursor(const CompressedPostingList& postings, SimdLevel level)
+    : postings_(&postings)
+    , level_(level)
+{
+    LoadBlock(0);
+}
+
+void CompressedPostingCursor::LoadBlock(size_t block)
+{
+    block_ = block;
+    pos_ = 0;
+    block_size_ = block < postings_->GetBlockCount() ? postings_->DecodeBlock(block, document_ids_, term_counts_, level_) : 0;
+}
+
+void CompressedPostingCursor::SkipTo(int document_id)
+{
+    if (!IsValid()) {
+        return;
+    }
+    if (postings_->GetBlockLastDocumentId(block_) < document_id) {
+        size_t block = block_ + 1;
+        while (block < postings_->GetBlockCount() && postings_->GetBlockLastDocumentId(block) < document_id) {
+            ++block;
+        }
+        LoadBlock(block);
+        if (!IsValid()) {
+            return;
+        }
+    }
+    pos_ = std::lower_bound(document_ids_ + pos_, document_ids_ + block_size_, document_id) - document_ids_;
+}
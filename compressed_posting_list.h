@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "cpu_features.h"
+
+// Неизменяемый сжатый список вхождений: id документов хранятся разностями соседних id,
+// TF - числом вхождений слова в документ (TF = число / длина документа).
+// Вхождения разбиты на блоки по BLOCK_SIZE. Разности и числа кодируются по схеме StreamVByte:
+// управляющий байт на четыре значения (длины 1-4 байта по 2 бита) и отдельно байты значений,
+// поэтому блок распаковывается перестановкой байтов без ветвлений.
+// Заголовок блока хранит последний id: поиск документа пропускает блоки не распаковывая.
+class CompressedPostingList {
+public:
+    static constexpr size_t BLOCK_SIZE = 128;
+
+    CompressedPostingList() = default;
+
+    // document_ids по возрастанию, term_counts - параллельный массив
+    CompressedPostingList(const std::vector<int>& document_ids, const std::vector<uint32_t>& term_counts);
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    size_t GetBlockCount() const
+    {
+        return blocks_.size();
+    }
+
+    int GetBlockLastDocumentId(size_t block) const
+    {
+        return blocks_[block].last_document_id;
+    }
+
+    // Распаковывает блок в буферы не меньше BLOCK_SIZE элементов, возвращает число вхождений в нём
+    size_t DecodeBlock(size_t block, int* document_ids, uint32_t* term_counts, SimdLevel level = GetBestSimdLevel()) const;
+
+    size_t MemoryUsage() const
+    {
+        return sizeof(*this) + blocks_.capacity() * sizeof(BlockHeader) + data_.capacity();
+    }
+
+private:
+    struct BlockHeader {
+        int last_document_id;
+        uint32_t offset;
+    };
+
+    std::vector<BlockHeader> blocks_;
+    // Блоки подряд; в конце запас, чтобы векторная распаковка могла читать по 16 байт
+    std::vector<uint8_t> data_;
+    size_t size_ = 0;
+};
+
+// Последовательный обход сжатого списка с распаковкой по одному блоку
+class CompressedPostingCursor {
+public:
+    explicit CompressedPostingCursor(const CompressedPostingList& postings, SimdLevel level = GetBestSimdLevel());
+
+    // false - список пройден до конца
+    bool IsValid() const
+    {
+        return pos_ < block_size_;
+    }
+
+    int GetDocumentId() const
+    {
+        return document_ids_[pos_];
+    }
+
+    uint32_t GetTermCount() const
+    {
+        return term_counts_[pos_];
+    }
+
+    void Next()
+    {
+        if (++pos_ == block_size_) {
+            LoadBlock(block_ + 1);
+        }
+    }
+
+    // Переходит к первому вхождению с id не меньше document_id
+    void SkipTo(int document_id);
+
+private:
+    const CompressedPostingList* postings_;
+    SimdLevel level_;
+    size_t block_ = 0;
+    size_t block_size_ = 0;
+    size_t pos_ = 0;
+    int document_ids_[CompressedPostingList::BLOCK_SIZE];
+    uint32_t term_counts_[CompressedPostingList::BLOCK_SIZE];
+
+    void LoadBlock(size_t block);
+};
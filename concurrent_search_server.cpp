@@ -0,0 +1,72 @@
+#include "concurrent_search_server.h"
+
+ConcurrentSearchServer::ConcurrentSearchServer(SearchServer server, size_t max_pending_changes)
+    : published_(std::make_shared<const SearchServer>(std::move(server)))
+    , max_pending_changes_(max_pending_changes)
+{
+}
+
+std::shared_ptr<const SearchServer> ConcurrentSearchServer::GetSnapshot() const
+{
+    return std::atomic_load(&published_);
+}
+
+uint64_t ConcurrentSearchServer::GetVersion() const
+{
+    return version_;
+}
+
+void ConcurrentSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings)
+{
+    std::lock_guard lock(write_mutex_);
+    GetDraft().AddDocument(document_id, document, status, ratings);
+    OnChange();
+}
+
+void ConcurrentSearchServer::RemoveDocument(int document_id)
+{
+    std::lock_guard lock(write_mutex_);
+    GetDraft().RemoveDocument(document_id);
+    OnChange();
+}
+
+void ConcurrentSearchServer::Commit()
+{
+    std::lock_guard lock(write_mutex_);
+    Publish();
+}
+
+size_t ConcurrentSearchServer::GetPendingChangeCount() const
+{
+    std::lock_guard lock(write_mutex_);
+    return pending_changes_;
+}
+
+SearchServer& ConcurrentSearchServer::GetDraft()
+{
+    if (!draft_) {
+        // Опубликованную версию меняет только этот поток под write_mutex_, поэтому
+        // копирование идёт без гонок с другими писателями, а читатели её не изменяют
+        draft_ = std::make_shared<SearchServer>(*published_);
+    }
+    return *draft_;
+}
+
+void ConcurrentSearchServer::OnChange()
+{
+    ++pending_changes_;
+    if (max_pending_changes_ > 0 && pending_changes_ >= max_pending_changes_) {
+        Publish();
+    }
+}
+
+void ConcurrentSearchServer::Publish()
+{
+    if (!draft_) {
+        return;
+    }
+    std::atomic_store(&published_, std::shared_ptr<const SearchServer>(std::move(draft_)));
+    draft_ = nullptr;
+    pending_changes_ = 0;
+    ++version_;
+}
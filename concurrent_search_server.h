@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+
+// SearchServer для одновременных чтений и записей.
+// Читатели работают с опубликованной неизменяемой версией индекса и не ждут писателей.
+// Писатели изменяют частную копию (черновик); Commit атомарно публикует её как новую версию.
+// Старая версия освобождается, когда её отпустит последний читатель.
+// Кеш запросов (SearchServer::EnableQueryCache) у каждой версии свой и пустой после публикации;
+// читатели не ждут друг друга на нём: занятый кеш пропускается.
+class ConcurrentSearchServer {
+public:
+    // max_pending_changes > 0 - черновик публикуется автоматически после стольких изменений
+    explicit ConcurrentSearchServer(SearchServer server, size_t max_pending_changes = 0);
+
+    // Текущая опубликованная версия; остаётся действительной, пока жив указатель
+    std::shared_ptr<const SearchServer> GetSnapshot() const;
+
+    // Число публикаций с момента создания
+    uint64_t GetVersion() const;
+
+    template <typename... Args>
+    std::vector<Document> FindTopDocuments(Args&&... args) const
+    {
+        return GetSnapshot()->FindTopDocuments(std::forward<Args>(args)...);
+    }
+
+    int GetDocumentCount() const
+    {
+        return GetSnapshot()->GetDocumentCount();
+    }
+
+    // Изменения проверяются и бросают исключения сразу, как у SearchServer,
+    // но видны читателям только после Commit
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    void RemoveDocument(int document_id);
+
+    void Commit();
+
+    size_t GetPendingChangeCount() const;
+
+private:
+    // Читается и заменяется только через std::atomic_load / std::atomic_store
+    std::shared_ptr<const SearchServer> published_;
+    std::atomic<uint64_t> version_{0};
+
+    const size_t max_pending_changes_;
+    mutable std::mutex write_mutex_;
+    // Копия опубликованной версии, создаётся при первом изменении после Commit
+    std::shared_ptr<SearchServer> draft_;
+    size_t pending_changes_ = 0;
+
+    SearchServer& GetDraft();
+
+    void OnChange();
+
+    void Publish();
+};
@@ -0,0 +1,32 @@
+#include "cpu_features.h"
+
+#include <initializer_list>
+
+bool IsSimdLevelSupported(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::SCALAR:
+        return true;
+#if defined(__x86_64__) || defined(__i386__)
+    case SimdLevel::SSE2:
+        return __builtin_cpu_supports("sse2");
+    case SimdLevel::AVX2:
+        return __builtin_cpu_supports("avx2");
+    case SimdLevel::AVX512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+SimdLevel GetBestSimdLevel() {
+    static const SimdLevel best_level = [] {
+        for (const SimdLevel level : {SimdLevel::AVX512, SimdLevel::AVX2, SimdLevel::SSE2}) {
+            if (IsSimdLevelSupported(level)) {
+                return level;
+            }
+        }
+        return SimdLevel::SCALAR;
+    }();
+    return best_level;
+}
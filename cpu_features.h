@@ -0,0 +1,14 @@
+#pragma once
+
+// Наборы SIMD-инструкций, между которыми выбирается реализация во время выполнения
+enum class SimdLevel {
+    SCALAR,
+    SSE2,
+    AVX2,
+    AVX512,
+};
+
+bool IsSimdLevelSupported(SimdLevel level);
+
+// Наилучший уровень, поддерживаемый процессором
+SimdLevel GetBestSimdLevel();
@@ -1,6 +1,6 @@
 #include "document.h"
 
-Document::Document(int id, double relevance, int rating) : id(id)
+Document::Document(int id, Relevance relevance, int rating) : id(id)
   , relevance(relevance)
   , rating(rating) {
 }
@@ -1,15 +1,37 @@
 #pragma once
 
+#include <cmath>
 #include <iostream>
+#include <limits>
+
+// Тип релевантности и TF. При сборке с -DSEARCH_SERVER_FLOAT_RELEVANCE - float:
+// TF в списках вхождений и буферы релевантности занимают вдвое меньше памяти.
+#ifdef SEARCH_SERVER_FLOAT_RELEVANCE
+using Relevance = float;
+#else
+using Relevance = double;
+#endif
+
+constexpr Relevance RELEVANCE_EPSILON = 1e-6;
+// Относительная часть порога равенства: шаг float растёт с величиной (при 8 он около 1e-6),
+// без неё ошибки округления решали бы порядок вместо рейтинга. Порог покрывает несколько округлений
+// при сложении и остаётся узким: сравнение с ним не транзитивно. Для double она пренебрежимо мала.
+constexpr Relevance RELEVANCE_RELATIVE_EPSILON = 8 * std::numeric_limits<Relevance>::epsilon();
+
+// Релевантности, различающиеся меньше чем на GetRelevanceTolerance от большей по модулю, равны
+inline Relevance GetRelevanceTolerance(Relevance relevance)
+{
+    return RELEVANCE_EPSILON + std::abs(relevance) * RELEVANCE_RELATIVE_EPSILON;
+}
 
 struct Document {
     Document() = default;
 
-    Document(int id, double relevance, int rating);
+    Document(int id, Relevance relevance, int rating);
 
 
     int id = 0;
-    double relevance = 0.0;
+    Relevance relevance = 0.0;
     int rating = 0;
 };
 
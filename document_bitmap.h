@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Множество внутренних индексов документов, по биту на документ.
+// После заполнения только читается, поэтому его можно проверять из нескольких потоков.
+class DocumentBitmap {
+public:
+    DocumentBitmap() = default;
+
+    explicit DocumentBitmap(size_t document_slot_count)
+        : words_((document_slot_count + 63) / 64, 0)
+    {
+    }
+
+    void Set(int document_index)
+    {
+        words_[static_cast<size_t>(document_index) >> 6] |= uint64_t{1} << (document_index & 63);
+    }
+
+    bool Test(int document_index) const
+    {
+        return (words_[static_cast<size_t>(document_index) >> 6] >> (document_index & 63)) & 1;
+    }
+
+    bool empty() const
+    {
+        return words_.empty();
+    }
+
+private:
+    std::vector<uint64_t> words_;
+};
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+#include "posting_list.h"
+#include "term_dictionary.h"
+
+// Слова документа с TF по возрастанию слов, как при обходе std::map<std::string_view, Relevance>.
+// Ссылается на данные индекса и действителен до его изменения.
+class WordFrequenciesView {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<std::string_view, Relevance>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator(const TermDictionary* terms, const int* term_id, const Relevance* term_freq)
+            : terms_(terms)
+            , term_id_(term_id)
+            , term_freq_(term_freq)
+        {
+        }
+
+        value_type operator*() const
+        {
+            return {terms_->GetTerm(*term_id_), *term_freq_};
+        }
+
+        Iterator& operator++()
+        {
+            ++term_id_;
+            ++term_freq_;
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator result = *this;
+            ++*this;
+            return result;
+        }
+
+        bool operator==(const Iterator& other) const
+        {
+            return term_id_ == other.term_id_;
+        }
+
+        bool operator!=(const Iterator& other) const
+        {
+            return term_id_ != other.term_id_;
+        }
+
+    private:
+        const TermDictionary* terms_;
+        const int* term_id_;
+        const Relevance* term_freq_;
+    };
+
+    WordFrequenciesView() = default;
+
+    WordFrequenciesView(const TermDictionary* terms, const int* term_ids, const Relevance* term_freqs, size_t size)
+        : terms_(terms)
+        , term_ids_(term_ids)
+        , term_freqs_(term_freqs)
+        , size_(size)
+    {
+    }
+
+    Iterator begin() const
+    {
+        return {terms_, term_ids_, term_freqs_};
+    }
+
+    Iterator end() const
+    {
+        return {terms_, term_ids_ + size_, term_freqs_ + size_};
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    // 1, если слово есть в документе; поиск двоичный
+    size_t count(std::string_view word) const
+    {
+        const int* last = term_ids_ + size_;
+        const int* it = std::lower_bound(term_ids_, last, word, [this](int term_id, std::string_view value) {
+            return terms_->GetTerm(term_id) < value;
+        });
+        return it != last && terms_->GetTerm(*it) == word ? 1 : 0;
+    }
+
+    friend bool operator==(const WordFrequenciesView& lhs, const WordFrequenciesView& rhs)
+    {
+        return lhs.size_ == rhs.size_ && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    }
+
+private:
+    const TermDictionary* terms_ = nullptr;
+    const int* term_ids_ = nullptr;
+    const Relevance* term_freqs_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Прямой индекс: пары (id термина, TF) всех документов в двух общих массивах,
+// у каждого документа - свой непрерывный отрезок. Отрезки удалённых документов
+// освобождаются при RemapDocuments.
+class ForwardIndex {
+public:
+    // Начинает документ со следующим индексом; AddTerm добавляет к нему слова по возрастанию
+    void AddDocument()
+    {
+        ranges_.push_back({term_ids_.size(), term_ids_.size()});
+    }
+
+    void AddTerm(int term_id, Relevance term_freq)
+    {
+        term_ids_.push_back(term_id);
+        term_freqs_.push_back(term_freq);
+        ++ranges_.back().end;
+    }
+
+    // Строит индекс по спискам вхождений. Слова документа идут в порядке id терминов,
+    // поэтому id терминов должны быть упорядочены так же, как сами слова.
+    void Assign(const std::vector<PostingList>& word_to_document_freqs, size_t document_count)
+    {
+        ranges_.assign(document_count, {0, 0});
+        size_t total_size = 0;
+        for (const PostingList& postings : word_to_document_freqs) {
+            for (const int document_index : postings.GetDocumentIds()) {
+                ++ranges_[document_index].end;
+            }
+            total_size += postings.size();
+        }
+        size_t offset = 0;
+        for (Range& range : ranges_) {
+            range.begin = offset;
+            offset += range.end;
+            range.end = range.begin;
+        }
+        term_ids_.resize(total_size);
+        term_freqs_.resize(total_size);
+        for (int term_id = 0; term_id < static_cast<int>(word_to_document_freqs.size()); ++term_id) {
+            const auto& document_ids = word_to_document_freqs[term_id].GetDocumentIds();
+            const auto& term_freqs = word_to_document_freqs[term_id].GetTermFreqs();
+            for (size_t i = 0; i < document_ids.size(); ++i) {
+                Range& range = ranges_[document_ids[i]];
+                term_ids_[range.end] = term_id;
+                term_freqs_[range.end] = term_freqs[i];
+                ++range.end;
+            }
+        }
+    }
+
+    // Место отрезка освобождается при RemapDocuments
+    void ClearDocument(int document_index)
+    {
+        ranges_[document_index].end = ranges_[document_index].begin;
+    }
+
+    // Оставляет документы с new_document_ids[index] >= 0 под новыми индексами и уплотняет массивы.
+    // Нумерация должна сохранять порядок.
+    void RemapDocuments(const std::vector<int>& new_document_ids)
+    {
+        size_t size = 0;
+        size_t document_count = 0;
+        for (size_t index = 0; index < ranges_.size(); ++index) {
+            if (new_document_ids[index] < 0) {
+                continue;
+            }
+            const Range range = ranges_[index];
+            std::copy(term_ids_.begin() + range.begin, term_ids_.begin() + range.end, term_ids_.begin() + size);
+            std::copy(term_freqs_.begin() + range.begin, term_freqs_.begin() + range.end, term_freqs_.begin() + size);
+            ranges_[document_count++] = {size, size + (range.end - range.begin)};
+            size += range.end - range.begin;
+        }
+        ranges_.resize(document_count);
+        term_ids_.resize(size);
+        term_freqs_.resize(size);
+        ranges_.shrink_to_fit();
+        term_ids_.shrink_to_fit();
+        term_freqs_.shrink_to_fit();
+    }
+
+    // Перенумерация терминов; порядок слов внутри документа не меняется
+    void RemapTerms(const std::vector<int>& new_term_ids)
+    {
+        for (int& term_id : term_ids_) {
+            term_id = new_term_ids[term_id];
+        }
+    }
+
+    WordFrequenciesView GetWordFrequencies(int document_index, const TermDictionary& terms) const
+    {
+        const Range range = ranges_[document_index];
+        return {&terms, term_ids_.data() + range.begin, term_freqs_.data() + range.begin, range.end - range.begin};
+    }
+
+    // Id терминов документа
+    std::pair<const int*, const int*> GetTermIds(int document_index) const
+    {
+        const Range range = ranges_[document_index];
+        return {term_ids_.data() + range.begin, term_ids_.data() + range.end};
+    }
+
+    size_t MemoryUsage() const
+    {
+        return sizeof(*this)
+            + ranges_.capacity() * sizeof(Range)
+            + term_ids_.capacity() * sizeof(int)
+            + term_freqs_.capacity() * sizeof(Relevance);
+    }
+
+private:
+    struct Range {
+        size_t begin;
+        size_t end;
+    };
+
+    std::vector<Range> ranges_;
+    std::vector<int> term_ids_;
+    std::vector<Relevance> term_freqs_;
+};
@@ -0,0 +1,138 @@
+#include "frozen_segment.h"
+
+#include <algorithm>
+#include <cmath>
+
+FrozenSegment::FrozenSegment(const SearchServer& index)
+{
+    std::vector<int> new_indices(index.document_external_ids_.size(), -1);
+    for (size_t document_index = 0; document_index < index.document_external_ids_.size(); ++document_index) {
+        if (index.document_removed_[document_index]) {
+            continue;
+        }
+        new_indices[document_index] = static_cast<int>(document_ids_.size());
+        document_ids_.push_back(index.document_external_ids_[document_index]);
+        document_ratings_.push_back(index.document_ratings_[document_index]);
+        document_statuses_.push_back(index.document_statuses_[document_index]);
+        inverse_document_lengths_.push_back(1.0 / index.document_word_counts_[document_index]);
+    }
+
+    // Термины по возрастанию слов, как и при слиянии
+    std::vector<int> term_ids;
+    for (int term_id = 0; term_id < static_cast<int>(index.word_to_document_freqs_.size()); ++term_id) {
+        if (!index.word_to_document_freqs_[term_id].empty()) {
+            term_ids.push_back(term_id);
+        }
+    }
+    std::sort(term_ids.begin(), term_ids.end(), [&index](int lhs, int rhs) {
+        return index.terms_.GetTerm(lhs) < index.terms_.GetTerm(rhs);
+    });
+    std::vector<int> document_indices;
+    std::vector<uint32_t> term_counts;
+    for (const int term_id : term_ids) {
+        const PostingList& postings = index.word_to_document_freqs_[term_id];
+        document_indices.clear();
+        term_counts.clear();
+        for (size_t i = 0; i < postings.size(); ++i) {
+            const int document_index = new_indices[postings.GetDocumentIds()[i]];
+            if (document_index < 0) {
+                continue;
+            }
+            document_indices.push_back(document_index);
+            // TF = число * (1.0 / длина), поэтому число восстанавливается округлением
+            const int word_count = index.document_word_counts_[postings.GetDocumentIds()[i]];
+            term_counts.push_back(static_cast<uint32_t>(std::llround(postings.GetTermFreqs()[i] * word_count)));
+        }
+        if (!document_indices.empty()) {
+            terms_.Intern(index.terms_.GetTerm(term_id));
+            postings_.emplace_back(document_indices, term_counts);
+        }
+    }
+}
+
+FrozenSegment::FrozenSegment(const std::vector<std::pair<const FrozenSegment*, const std::set<int>*>>& sources)
+{
+    // Документы источников нумеруются подряд, поэтому списки вхождений остаются упорядоченными
+    std::vector<std::vector<int>> new_indices(sources.size());
+    std::vector<std::string_view> words;
+    for (size_t source = 0; source < sources.size(); ++source) {
+        const FrozenSegment& segment = *sources[source].first;
+        const std::set<int>& deleted_ids = *sources[source].second;
+        new_indices[source].assign(segment.document_ids_.size(), -1);
+        for (size_t document_index = 0; document_index < segment.document_ids_.size(); ++document_index) {
+            if (deleted_ids.count(segment.document_ids_[document_index]) > 0) {
+                continue;
+            }
+            new_indices[source][document_index] = static_cast<int>(document_ids_.size());
+            document_ids_.push_back(segment.document_ids_[document_index]);
+            document_ratings_.push_back(segment.document_ratings_[document_index]);
+            document_statuses_.push_back(segment.document_statuses_[document_index]);
+            inverse_document_lengths_.push_back(segment.inverse_document_lengths_[document_index]);
+        }
+        for (int term_id = 0; term_id < static_cast<int>(segment.terms_.size()); ++term_id) {
+            words.push_back(segment.terms_.GetTerm(term_id));
+        }
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    int block_ids[CompressedPostingList::BLOCK_SIZE];
+    uint32_t block_counts[CompressedPostingList::BLOCK_SIZE];
+    std::vector<int> document_indices;
+    std::vector<uint32_t> term_counts;
+    for (const auto word : words) {
+        document_indices.clear();
+        term_counts.clear();
+        for (size_t source = 0; source < sources.size(); ++source) {
+            const CompressedPostingList* postings = sources[source].first->FindPostings(word);
+            if (postings == nullptr) {
+                continue;
+            }
+            for (size_t block = 0; block < postings->GetBlockCount(); ++block) {
+                const size_t count = postings->DecodeBlock(block, block_ids, block_counts);
+                for (size_t i = 0; i < count; ++i) {
+                    const int document_index = new_indices[source][block_ids[i]];
+                    if (document_index >= 0) {
+                        document_indices.push_back(document_index);
+                        term_counts.push_back(block_counts[i]);
+                    }
+                }
+            }
+        }
+        if (!document_indices.empty()) {
+            terms_.Intern(word);
+            postings_.emplace_back(document_indices, term_counts);
+        }
+    }
+}
+
+void FrozenSegment::CollectStatistics(const std::vector<std::string_view>& plus_words, CorpusStatistics& statistics) const
+{
+    // Документы, удалённые из сегмента до слияния, остаются в списках вхождений, поэтому
+    // учитываются и в числе документов, и в частотах слов
+    statistics.document_count += GetDocumentCount();
+    for (const auto word : plus_words) {
+        const CompressedPostingList* postings = FindPostings(word);
+        statistics.document_freqs[word] += postings == nullptr ? 0 : static_cast<int>(postings->size());
+    }
+}
+
+size_t FrozenSegment::MemoryUsage() const
+{
+    size_t result = sizeof(*this) + terms_.MemoryUsage()
+        + postings_.capacity() * sizeof(CompressedPostingList)
+        + document_ids_.capacity() * sizeof(int)
+        + document_ratings_.capacity() * sizeof(int)
+        + document_statuses_.capacity() * sizeof(DocumentStatus)
+        + inverse_document_lengths_.capacity() * sizeof(double);
+    for (const CompressedPostingList& postings : postings_) {
+        result += postings.MemoryUsage() - sizeof(CompressedPostingList);
+    }
+    return result;
+}
+
+const CompressedPostingList* FrozenSegment::FindPostings(std::string_view word) const
+{
+    const int term_id = terms_.Find(word);
+    return term_id < 0 ? nullptr : &postings_[term_id];
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "compressed_posting_list.h"
+#include "document.h"
+#include "query_context.h"
+#include "scoring_kernel.h"
+#include "search_server.h"
+#include "term_dictionary.h"
+#include "top_documents.h"
+
+// Неизменяемый сегмент SegmentedSearchServer со сжатыми списками вхождений.
+// Вместо TF в списках хранится число вхождений слова (CompressedPostingList), у документа -
+// обратная длина. TF = число * (1.0 / длина) восстанавливается при подсчёте так же, как его
+// вычисляет AddDocument, поэтому релевантность побитово совпадает с SearchServer.
+// Прямого индекса нет: сегменты сливаются по спискам вхождений.
+class FrozenSegment {
+public:
+    // Сжимает живые документы индекса
+    explicit FrozenSegment(const SearchServer& index);
+
+    // Слияние: документы источников по порядку, кроме удалённых из источника
+    explicit FrozenSegment(const std::vector<std::pair<const FrozenSegment*, const std::set<int>*>>& sources);
+
+    int GetDocumentCount() const
+    {
+        return static_cast<int>(document_ids_.size());
+    }
+
+    // Внешние id документов в порядке внутренних индексов
+    const std::vector<int>& GetDocumentIds() const
+    {
+        return document_ids_;
+    }
+
+    // plus_words - нормализованные плюс-слова запроса; число документов и частоты слов считаются
+    // по одному множеству - всем документам сегмента
+    void CollectStatistics(const std::vector<std::string_view>& plus_words, CorpusStatistics& statistics) const;
+
+    // Поиск с IDF по статистике корпуса; слова запроса нормализованы
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const CorpusStatistics& statistics, const std::vector<std::string_view>& plus_words,
+        const std::vector<std::string_view>& minus_words, DocumentPredicate document_predicate, size_t max_result_count) const;
+
+    size_t MemoryUsage() const;
+
+private:
+    TermDictionary terms_;
+    // Списки вхождений по id термина, все непустые
+    std::vector<CompressedPostingList> postings_;
+    std::vector<int> document_ids_;
+    std::vector<int> document_ratings_;
+    std::vector<DocumentStatus> document_statuses_;
+    std::vector<double> inverse_document_lengths_;
+
+    // Список вхождений слова или nullptr
+    const CompressedPostingList* FindPostings(std::string_view word) const;
+};
+
+template <typename DocumentPredicate>
+std::vector<Document> FrozenSegment::FindTopDocuments(const CorpusStatistics& statistics, const std::vector<std::string_view>& plus_words,
+    const std::vector<std::string_view>& minus_words, DocumentPredicate document_predicate, size_t max_result_count) const
+{
+    int block_ids[CompressedPostingList::BLOCK_SIZE];
+    uint32_t block_counts[CompressedPostingList::BLOCK_SIZE];
+    Relevance block_term_freqs[CompressedPostingList::BLOCK_SIZE];
+
+    // Плотный накопитель потока переиспользуется между запросами и обнуляется только по
+    // затронутым документам, поэтому запрос стоит порядка числа вхождений, а не размера сегмента
+    thread_local QueryContext context;
+    context.Prepare(document_ids_.size());
+
+    // Документы с минус-словами отмечаются до подсчёта, как в SearchServer
+    bool has_excluded = false;
+    for (const auto word : minus_words) {
+        const CompressedPostingList* postings = FindPostings(word);
+        if (postings == nullptr) {
+            continue;
+        }
+        for (size_t block = 0; block < postings->GetBlockCount(); ++block) {
+            const size_t count = postings->DecodeBlock(block, block_ids, block_counts);
+            for (size_t i = 0; i < count; ++i) {
+                context.Exclude(block_ids[i]);
+            }
+        }
+        has_excluded = true;
+    }
+
+    // Блок распаковывается, исключённые документы отбрасываются, TF восстанавливается
+    // и блок подаётся в ядро подсчёта
+    for (const auto word : plus_words) {
+        const CompressedPostingList* postings = FindPostings(word);
+        if (postings == nullptr) {
+            continue;
+        }
+        const Relevance inverse_document_freq = statistics.ComputeInverseDocumentFreq(word);
+        for (size_t block = 0; block < postings->GetBlockCount(); ++block) {
+            const size_t count = postings->DecodeBlock(block, block_ids, block_counts);
+            size_t kept = 0;
+            for (size_t i = 0; i < count; ++i) {
+                const int document_index = block_ids[i];
+                if (has_excluded && context.IsExcluded(document_index)) {
+                    continue;
+                }
+                block_ids[kept] = document_index;
+                block_term_freqs[kept] = static_cast<Relevance>(block_counts[i] * inverse_document_lengths_[document_index]);
+                ++kept;
+            }
+            AccumulateScores(block_ids, block_term_freqs, kept, inverse_document_freq, context.scores_.data());
+            context.MarkScored(block_ids, kept);
+        }
+    }
+
+    // Предикат вызывается после сброса накопителя
+    std::vector<std::pair<int, Relevance>> scored;
+    context.ForEachScored([&scored](int document_index, Relevance relevance) {
+        scored.push_back({document_index, relevance});
+    });
+    context.Reset();
+    TopDocumentsSelector selector(max_result_count);
+    for (const auto& [document_index, relevance] : scored) {
+        if (document_predicate(document_ids_[document_index], document_statuses_[document_index], document_ratings_[document_index])) {
+            selector.Add({document_ids_[document_index], relevance, document_ratings_[document_index]});
+        }
+    }
+    return selector.Extract();
+}
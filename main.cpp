@@ -1,19 +1,64 @@
 #include "search_server.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
 #include <map>
+#include <new>
+#include <numeric>
+#include <random>
 #include <set>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 
+#include "compressed_posting_list.h"
+#include "concurrent_search_server.h"
+#include "frozen_segment.h"
+#include "process_queries.h"
+#include "remove_duplicates.h"
+#include "scoring_kernel.h"
+#include "segmented_search_server.h"
 #include "test_example_functions.h"
 #include "search_server.h"
+#include "term_dictionary.h"
 
 using namespace std;
 
+// Счётчик выделений памяти: им проверяется, что поиск с QueryContext не выделяет память.
+// Замена глобальных operator new/delete попала бы и в демонстрационную программу,
+// поэтому включается только при сборке тестов с -DSEARCH_SERVER_COUNT_ALLOCATIONS.
+#ifdef SEARCH_SERVER_COUNT_ALLOCATIONS
+static atomic<size_t> allocation_count{0};
+
+// noinline: иначе GCC видит free для памяти из new после встраивания и предупреждает
+__attribute__((noinline)) void* operator new(size_t size) {
+    ++allocation_count;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+__attribute__((noinline)) void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+#endif
+
 template <typename T, typename U>
 void AssertEqualImpl(const T& t, const U& u, const string& t_str, const string& u_str, const string& file,
                      const string& func, unsigned line, const string& hint) {
@@ -260,6 +305,1375 @@ void TestUSersPredicate()
 
 
 }
+void TestPostingListOrder()
+{
+    // Документы добавляются не по порядку id, списки вхождений должны остаться отсортированными
+    SearchServer server("and"s);
+    server.AddDocument(5, "white cat"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(1, "black cat cat"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocument(3, "black dog"s, DocumentStatus::ACTUAL, {3});
+
+    auto docs = server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(docs.size(), 2);
+    ASSERT_EQUAL(docs[0].id, 1);
+    ASSERT_EQUAL(docs[1].id, 5);
+
+    const string query = "cat dog"s;
+    const auto [words, status] = server.MatchDocument(query, 3);
+    ASSERT_EQUAL(words.size(), 1);
+    ASSERT_EQUAL(words[0], "dog"s);
+
+    server.RemoveDocument(1);
+    docs = server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(docs.size(), 1);
+    ASSERT_EQUAL(docs[0].id, 5);
+    ASSERT_EQUAL(server.FindTopDocuments("black"s).size(), 1);
+}
+
+void TestTopDocumentsCount()
+{
+    SearchServer server("and"s);
+    // Чем больше документ, тем меньше TF слова cat
+    string text = "cat"s;
+    for (int id = 0; id < 60; ++id) {
+        server.AddDocument(id, text, DocumentStatus::ACTUAL, {id});
+        text += " dog"s;
+    }
+    server.AddDocument(100, "cat"s, DocumentStatus::ACTUAL, {1000});
+    for (int id = 200; id < 300; ++id) {
+        server.AddDocument(id, "bird"s, DocumentStatus::ACTUAL, {id});
+    }
+
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s).size(), MAX_RESULT_DOCUMENT_COUNT);
+
+    for (const auto& docs : {server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 50),
+                             server.FindTopDocuments(execution::par, "cat"s, DocumentStatus::ACTUAL, 50)}) {
+        ASSERT_EQUAL(docs.size(), 50);
+        // При равной релевантности выше документ с большим рейтингом
+        ASSERT_EQUAL(docs[0].id, 100);
+        for (int i = 1; i < 50; ++i) {
+            ASSERT_EQUAL(docs[i].id, i - 1);
+        }
+    }
+    ASSERT(server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 0).empty());
+}
+
+void TestScoreTable()
+{
+    // Сверяем таблицу с открытой адресацией с обычным map на случайных вставках и удалениях
+    ScoreTable table;
+    map<int, double> expected;
+    for (int i = 0; i < 10000; ++i) {
+        const int key = (i * 7919) % 1543;
+        if (i % 3 == 0) {
+            table.Erase(key);
+            expected.erase(key);
+        } else {
+            table[key] += 1.0;
+            expected[key] += 1.0;
+        }
+    }
+    ASSERT_EQUAL(table.size(), expected.size());
+    map<int, double> actual;
+    table.ForEach([&actual](int key, double value) {
+        actual[key] = value;
+    });
+    ASSERT(actual == expected);
+
+    ScoreTable other;
+    other[1] = 2.0;
+    other[100000] = 3.0;
+    table.Merge(other);
+    expected[1] += 2.0;
+    expected[100000] += 3.0;
+    actual.clear();
+    table.ForEach([&actual](int key, double value) {
+        actual[key] = value;
+    });
+    ASSERT(actual == expected);
+}
+
+void TestRemoveAndReAddDocument()
+{
+    SearchServer server("and"s);
+    server.AddDocument(7, "white cat"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "black cat"s, DocumentStatus::BANNED, {5});
+    server.AddDocument(4, "black dog"s, DocumentStatus::ACTUAL, {3});
+
+    server.RemoveDocument(execution::par, 2);
+    ASSERT_EQUAL(server.GetDocumentCount(), 2);
+    ASSERT(server.GetWordFrequencies(2).empty());
+    ASSERT(server.FindTopDocuments("cat"s, DocumentStatus::BANNED).empty());
+
+    // Тот же id можно добавить повторно, он получит новый внутренний индекс
+    server.AddDocument(2, "grey cat"s, DocumentStatus::IRRELEVANT, {9});
+    const vector<int> ids(server.begin(), server.end());
+    ASSERT(ids == vector<int>({2, 4, 7}));
+
+    const auto docs = server.FindTopDocuments("grey"s, DocumentStatus::IRRELEVANT);
+    ASSERT_EQUAL(docs.size(), 1);
+    ASSERT_EQUAL(docs[0].id, 2);
+    ASSERT_EQUAL(docs[0].rating, 9);
+    const string query = "cat"s;
+    const auto [words, status] = server.MatchDocument(query, 2);
+    ASSERT_EQUAL(words.size(), 1);
+    ASSERT(status == DocumentStatus::IRRELEVANT);
+
+    server.RemoveDocument(4);
+    ASSERT(server.FindTopDocuments("dog"s).empty());
+    ASSERT_EQUAL(server.FindTopDocuments("black"s).size(), 0);
+}
+
+void TestAddDocuments()
+{
+    const vector<string> texts = {"white cat"s, "black cat cat"s, "black dog"s};
+    SearchServer single("and"s);
+    SearchServer batch("and"s);
+    vector<DocumentToAdd> documents;
+    for (int i = 0; i < static_cast<int>(texts.size()); ++i) {
+        single.AddDocument(i * 10, texts[i], DocumentStatus::ACTUAL, {i, 1});
+        documents.push_back({i * 10, texts[i], DocumentStatus::ACTUAL, {i, 1}});
+    }
+    batch.AddDocuments(execution::par, documents);
+
+    ASSERT_EQUAL(batch.GetDocumentCount(), single.GetDocumentCount());
+    for (const int id : single) {
+        ASSERT(batch.GetWordFrequencies(id) == single.GetWordFrequencies(id));
+    }
+    const auto expected = single.FindTopDocuments("black cat"s);
+    const auto actual = batch.FindTopDocuments("black cat"s);
+    ASSERT_EQUAL(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQUAL(actual[i].id, expected[i].id);
+        ASSERT_EQUAL(actual[i].rating, expected[i].rating);
+    }
+
+    // Ошибка в любом документе пакета - не добавляется ни один
+    const vector<pair<int, string>> invalid_batches = {{40, "bad\x12word"s}, {10, "existing id"s}, {-1, "negative id"s}};
+    for (const auto& [id, text] : invalid_batches) {
+        const vector<DocumentToAdd> bad = {{50, "fine"s, DocumentStatus::ACTUAL, {}}, {id, text, DocumentStatus::ACTUAL, {}}};
+        try {
+            batch.AddDocuments(execution::par, bad);
+            ASSERT_HINT(false, "invalid_argument expected"s);
+        } catch (const invalid_argument&) {
+        }
+        ASSERT_EQUAL(batch.GetDocumentCount(), 3);
+    }
+    const vector<DocumentToAdd> duplicates = {{60, "a"s, DocumentStatus::ACTUAL, {}}, {60, "b"s, DocumentStatus::ACTUAL, {}}};
+    try {
+        batch.AddDocuments(duplicates);
+        ASSERT_HINT(false, "invalid_argument expected"s);
+    } catch (const invalid_argument&) {
+    }
+    ASSERT_EQUAL(batch.GetDocumentCount(), 3);
+}
+
+void TestSnapshotRoundTrip()
+{
+    SearchServer server("and in"s);
+    server.AddDocument(3, "white cat and fashion collar"s, DocumentStatus::ACTUAL, {8, -3});
+    server.AddDocument(1, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    server.AddDocument(8, "groomed dog expressive eyes"s, DocumentStatus::BANNED, {5, -12, 2, 1});
+    server.AddDocument(5, "groomed starling evgeny"s, DocumentStatus::ACTUAL, {9});
+    server.RemoveDocument(1);
+
+    const string path = "search_server_snapshot_test.bin"s;
+    server.SaveSnapshot(path);
+    const SearchServer loaded = SearchServer::LoadSnapshot(path);
+    remove(path.c_str());
+
+    ASSERT_EQUAL(loaded.GetDocumentCount(), server.GetDocumentCount());
+    ASSERT(vector<int>(loaded.begin(), loaded.end()) == vector<int>(server.begin(), server.end()));
+    for (const int id : server) {
+        ASSERT(loaded.GetWordFrequencies(id) == server.GetWordFrequencies(id));
+    }
+    for (const string& query : {"fluffy groomed cat"s, "cat -collar"s, "in and"s}) {
+        const auto expected = server.FindTopDocuments(query);
+        const auto actual = loaded.FindTopDocuments(query);
+        ASSERT_EQUAL(actual.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQUAL(actual[i].id, expected[i].id);
+            ASSERT_EQUAL(actual[i].rating, expected[i].rating);
+            ASSERT(abs(actual[i].relevance - expected[i].relevance) < 1e-9);
+        }
+    }
+    const string query = "dog eyes"s;
+    const auto [words, status] = loaded.MatchDocument(query, 8);
+    ASSERT_EQUAL(words.size(), 2);
+    ASSERT(status == DocumentStatus::BANNED);
+
+    try {
+        SearchServer::LoadSnapshot("missing_snapshot.bin"s);
+        ASSERT_HINT(false, "runtime_error expected"s);
+    } catch (const runtime_error&) {
+    }
+
+    // Повреждённые снимки: без стоп-слов и с двумя документами смещения полей фиксированы
+    // (заголовок 16 байт, число стоп-слов, число документов, с 32 - id, с 40 - рейтинги,
+    // с 48 - статусы, с 56 - длины, далее слова "bird" (байты с 76, TF с 96) и "cat";
+    // индексы документов "cat" - с 120)
+    SearchServer small(""s);
+    small.AddDocument(10, "cat"s, DocumentStatus::ACTUAL, {1});
+    small.AddDocument(20, "bird cat"s, DocumentStatus::ACTUAL, {2});
+    small.SaveSnapshot(path);
+    string bytes;
+    {
+        ifstream in(path, ios::binary);
+        bytes.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+    const auto read_int = [&bytes](size_t offset) {
+        int value;
+        memcpy(&value, bytes.data() + offset, sizeof(value));
+        return value;
+    };
+    ASSERT_EQUAL(read_int(32), 10);
+    ASSERT_EQUAL(read_int(36), 20);
+    ASSERT_EQUAL(read_int(56), 1);
+    ASSERT_EQUAL(read_int(60), 2);
+    ASSERT_EQUAL(read_int(120), 0);
+    ASSERT_EQUAL(read_int(124), 1);
+    ASSERT_EQUAL(bytes.substr(76, 4), "bird"s);
+    double bird_term_freq;
+    memcpy(&bird_term_freq, bytes.data() + 96, sizeof(bird_term_freq));
+    ASSERT_EQUAL(bird_term_freq, 0.5);
+    const auto expect_corrupted = [&path](const string& content) {
+        {
+            ofstream out(path, ios::binary | ios::trunc);
+            out.write(content.data(), content.size());
+        }
+        try {
+            SearchServer::LoadSnapshot(path);
+            ASSERT_HINT(false, "runtime_error expected"s);
+        } catch (const runtime_error&) {
+        }
+    };
+    const auto patched = [&bytes](size_t offset, int value) {
+        string result = bytes;
+        memcpy(result.data() + offset, &value, sizeof(value));
+        return result;
+    };
+    expect_corrupted(bytes.substr(0, 100));
+    expect_corrupted(bytes.substr(0, 10));
+    expect_corrupted("NOTASNAP"s + bytes.substr(8));
+    expect_corrupted(patched(36, 10));
+    expect_corrupted(patched(32, -5));
+    expect_corrupted(patched(48, 77));
+    expect_corrupted(patched(60, -2));
+    string unordered = patched(120, 1);
+    memcpy(unordered.data() + 124, "\0\0\0\0", 4);
+    expect_corrupted(unordered);
+    expect_corrupted(patched(124, 5));
+    // Слово и TF, которые AddDocument не пропустил бы
+    string invalid_word = bytes;
+    invalid_word[76] = '\x01';
+    expect_corrupted(invalid_word);
+    for (const double term_freq : {numeric_limits<double>::quiet_NaN(), -0.5, 0.0, 2.0}) {
+        string invalid_term_freq = bytes;
+        memcpy(invalid_term_freq.data() + 96, &term_freq, sizeof(term_freq));
+        expect_corrupted(invalid_term_freq);
+    }
+    // Запись идёт через временный файл, который после сохранения не остаётся
+    small.SaveSnapshot(path);
+    ASSERT(!ifstream(path + ".tmp"s));
+    ASSERT_EQUAL(SearchServer::LoadSnapshot(path).GetDocumentCount(), 2);
+
+    // Недопустимое стоп-слово в снимке - тоже runtime_error
+    SearchServer with_stop_words("in"s);
+    with_stop_words.SaveSnapshot(path);
+    {
+        ifstream in(path, ios::binary);
+        bytes.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+    ASSERT_EQUAL(bytes.substr(28, 2), "in"s);
+    bytes[28] = '\x01';
+    expect_corrupted(bytes);
+    remove(path.c_str());
+}
+
+void TestTermDictionary()
+{
+    TermDictionary terms;
+    const int cat = terms.Intern("cat"s);
+    const int dog = terms.Intern("dog"s);
+    ASSERT(cat != dog);
+    ASSERT_EQUAL(terms.Intern("cat"s), cat);
+    ASSERT_EQUAL(terms.Find("dog"s), dog);
+    ASSERT_EQUAL(terms.Find("bird"s), -1);
+    ASSERT_EQUAL(terms.GetTerm(cat), "cat"s);
+
+    // Длинный термин не помещается в обычный блок пула
+    const string long_term(100'000, 'x');
+    const int long_id = terms.Intern(long_term);
+    ASSERT_EQUAL(terms.GetTerm(long_id), long_term);
+
+    // Копия продолжает независимо, строки оригинала остаются действительными
+    TermDictionary copy = terms;
+    const int copy_bird = copy.Intern("bird"s);
+    const int bird = terms.Intern("parrot"s);
+    ASSERT_EQUAL(copy_bird, bird);
+    ASSERT_EQUAL(copy.GetTerm(copy_bird), "bird"s);
+    ASSERT_EQUAL(terms.GetTerm(bird), "parrot"s);
+    ASSERT_EQUAL(copy.GetTerm(cat), "cat"s);
+    ASSERT_EQUAL(terms.Find("bird"s), -1);
+    ASSERT_EQUAL(copy.size(), terms.size());
+}
+
+void TestRelevanceTracksIndexChanges()
+{
+    SearchServer server("and"s);
+    server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "cat bird bird fish"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocument(3, "dog"s, DocumentStatus::ACTUAL, {3});
+
+    // Закешированный IDF должен пересчитываться при добавлении и удалении документов
+    auto docs = server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(docs.size(), 2);
+    ASSERT_EQUAL(docs[0].id, 1);
+    ASSERT(abs(docs[0].relevance - 0.5 * log(3.0 / 2.0)) < 1e-6);
+    ASSERT(abs(docs[1].relevance - 0.25 * log(3.0 / 2.0)) < 1e-6);
+
+    server.AddDocument(4, "fish"s, DocumentStatus::ACTUAL, {4});
+    docs = server.FindTopDocuments("cat"s);
+    ASSERT(abs(docs[0].relevance - 0.5 * log(4.0 / 2.0)) < 1e-6);
+
+    server.RemoveDocument(2);
+    docs = server.FindTopDocuments("cat fish"s);
+    ASSERT_EQUAL(docs.size(), 2);
+    ASSERT_EQUAL(docs[0].id, 4);
+    ASSERT(abs(docs[0].relevance - log(3.0)) < 1e-6);
+    ASSERT(abs(docs[1].relevance - 0.5 * log(3.0)) < 1e-6);
+}
+
+void TestQueryCache()
+{
+    SearchServer server("and"s);
+    server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "black cat"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocument(3, "black dog"s, DocumentStatus::BANNED, {3});
+    server.EnableQueryCache(2);
+
+    const auto first = server.FindTopDocuments("cat black"s);
+    // Тот же запрос после нормализации (порядок, повторы) и в другом режиме выполнения
+    const auto second = server.FindTopDocuments(execution::par, "black cat cat"s);
+    ASSERT_EQUAL(server.GetQueryCacheStats().misses, 1);
+    ASSERT_EQUAL(server.GetQueryCacheStats().hits, 1);
+    ASSERT_EQUAL(second.size(), first.size());
+    ASSERT_EQUAL(second[0].id, first[0].id);
+
+    // Статус и размер выдачи входят в ключ
+    ASSERT_EQUAL(server.FindTopDocuments("cat black"s, DocumentStatus::BANNED).size(), 1);
+    server.FindTopDocuments("cat black"s, DocumentStatus::ACTUAL, 1);
+    ASSERT_EQUAL(server.GetQueryCacheStats().misses, 3);
+    ASSERT_EQUAL(server.GetQueryCacheStats().evictions, 1);
+
+    // Изменение индекса сбрасывает кеш
+    server.AddDocument(4, "black black cat"s, DocumentStatus::BANNED, {4});
+    const auto banned = server.FindTopDocuments("cat black"s, DocumentStatus::BANNED);
+    ASSERT_EQUAL(banned.size(), 2);
+    ASSERT_EQUAL(server.GetQueryCacheStats().hits, 1);
+    server.RemoveDocument(4);
+    ASSERT_EQUAL(server.FindTopDocuments("cat black"s, DocumentStatus::BANNED).size(), 1);
+    ASSERT_EQUAL(server.GetQueryCacheStats().misses, 5);
+    ASSERT_EQUAL(server.GetQueryCacheStats().contended, 0);
+
+    server.EnableQueryCache(0);
+    server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(server.GetQueryCacheStats().misses, 0);
+}
+
+void TestQueryContextDoesNotAllocate()
+{
+    SearchServer server("and with"s);
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    server.AddDocument(3, "big cat nasty hair"s, DocumentStatus::ACTUAL, {1, 2, 8});
+    server.AddDocument(4, "big dog cat Vladislav"s, DocumentStatus::BANNED, {1, 3, 2});
+
+    const vector<string> queries = {"curly nasty cat"s, "funny -rat pet"s, "big dog hair -Vladislav"s, "and with"s};
+    QueryContext context;
+    // Первый проход выделяет буферы контекста
+    for (const auto& query : queries) {
+        const auto& docs = server.FindTopDocuments(context, query);
+        const auto expected = server.FindTopDocuments(query);
+        ASSERT_EQUAL(docs.size(), expected.size());
+        for (size_t i = 0; i < docs.size(); ++i) {
+            ASSERT_EQUAL(docs[i].id, expected[i].id);
+        }
+        for (const int id : server) {
+            const auto [words, status] = server.MatchDocument(context, query, id);
+            const auto [expected_words, expected_status] = server.MatchDocument(query, id);
+            ASSERT(words == expected_words);
+            ASSERT(status == expected_status);
+        }
+    }
+
+#ifdef SEARCH_SERVER_COUNT_ALLOCATIONS
+    const size_t allocations_before = allocation_count;
+    size_t found = 0;
+    for (int i = 0; i < 100; ++i) {
+        for (const auto& query : queries) {
+            found += server.FindTopDocuments(context, query).size();
+            found += get<0>(server.MatchDocument(context, query, 3)).size();
+        }
+    }
+    const size_t allocations = allocation_count - allocations_before;
+    ASSERT_EQUAL(allocations, 0);
+    ASSERT(found > 0);
+#endif
+}
+
+void TestSplitIntoWordsImplementations()
+{
+    // Все реализации разбиения должны совпадать со скалярной, в том числе на границах блоков
+    mt19937 generator(42);
+    const string alphabet = "ab  c\x7f\x80\xff"s;
+    vector<string_view> expected;
+    vector<string_view> actual;
+    for (int length = 0; length < 200; ++length) {
+        string text;
+        for (int i = 0; i < length; ++i) {
+            text.push_back(alphabet[uniform_int_distribution<size_t>(0, alphabet.size() - 1)(generator)]);
+        }
+        for (const int invalid_pos : {-1, length / 2, length - 1}) {
+            if (invalid_pos >= 0) {
+                text[invalid_pos] = '\x1f';
+            }
+            const size_t expected_invalid = SplitIntoWordsChecked(SimdLevel::SCALAR, text, expected);
+            ASSERT_EQUAL(expected_invalid, invalid_pos >= 0 ? static_cast<size_t>(text.find('\x1f')) : string_view::npos);
+            for (const SimdLevel level : {SimdLevel::SSE2, SimdLevel::AVX2}) {
+                if (!IsSimdLevelSupported(level)) {
+                    continue;
+                }
+                ASSERT_EQUAL(SplitIntoWordsChecked(level, text, actual), expected_invalid);
+                ASSERT(actual == expected);
+            }
+        }
+    }
+
+    SearchServer server("and"s);
+    try {
+        server.AddDocument(1, "valid words and a bro\x01ken one and another\x02"s, DocumentStatus::ACTUAL, {});
+        ASSERT_HINT(false, "invalid_argument expected"s);
+    } catch (const invalid_argument& e) {
+        ASSERT_EQUAL(string(e.what()), "Word bro\x01ken is invalid"s);
+    }
+    ASSERT_EQUAL(server.GetDocumentCount(), 0);
+}
+
+void TestProcessQueriesStream()
+{
+    SearchServer server("and with"s);
+    int id = 0;
+    for (const string& text : {"funny pet and nasty rat"s, "funny pet with curly hair"s, "big cat nasty hair"s, "big dog cat Vladislav"s, "big dog hamster Borya"s}) {
+        server.AddDocument(++id, text, DocumentStatus::ACTUAL, {1, 2});
+    }
+    vector<string> queries;
+    for (int i = 0; i < 50; ++i) {
+        queries.push_back(i % 3 == 0 ? "nasty rat -not"s : i % 3 == 1 ? "big cat -hair"s : "curly dog"s);
+    }
+    const auto expected = ProcessQueries(server, queries);
+
+    for (const size_t depth : {1, 3, 0}) {
+        size_t next_index = 0;
+        ProcessQueriesStream(server, queries.begin(), queries.end(), [&](size_t index, const vector<Document>& documents) {
+            ASSERT_EQUAL(index, next_index++);
+            ASSERT_EQUAL(documents.size(), expected[index].size());
+            for (size_t i = 0; i < documents.size(); ++i) {
+                ASSERT_EQUAL(documents[i].id, expected[index][i].id);
+            }
+        }, depth);
+        ASSERT_EQUAL(next_index, queries.size());
+    }
+
+    istringstream input("nasty rat -not\nbig cat -hair\n"s);
+    size_t result_count = 0;
+    ProcessQueriesStream(server, input, [&](size_t index, const vector<Document>& documents) {
+        ASSERT_EQUAL(documents.size(), expected[index].size());
+        ++result_count;
+    });
+    ASSERT_EQUAL(result_count, 2u);
+
+    // Ошибка в запросе прерывает обработку, результаты до неё уже выданы
+    queries[5] = "big --cat"s;
+    result_count = 0;
+    try {
+        ProcessQueriesStream(server, queries.begin(), queries.end(), [&](size_t, const vector<Document>&) {
+            ++result_count;
+        }, 2);
+        ASSERT_HINT(false, "invalid_argument expected"s);
+    } catch (const invalid_argument&) {
+    }
+    ASSERT_EQUAL(result_count, 5u);
+
+    const auto joined = ProcessQueriesJoined(server, {"nasty rat -not"s, "curly dog"s});
+    ASSERT_EQUAL(joined.size(), expected[0].size() + expected[2].size());
+}
+
+void TestQueryExecutor()
+{
+    QueryExecutor executor(4);
+    ASSERT_EQUAL(executor.GetWorkerCount(), 4u);
+
+    // Каждый индекс обрабатывается ровно один раз, в том числе при вложенных вызовах
+    vector<int> visits(1000);
+    executor.ParallelFor(visits.size() / 10, [&](size_t outer) {
+        executor.ParallelFor(10, [&](size_t inner) {
+            ++visits[outer * 10 + inner];
+        });
+    });
+    ASSERT(all_of(visits.begin(), visits.end(), [](int count) { return count == 1; }));
+    uint64_t executed = 0;
+    for (const auto& stats : executor.GetWorkerStats()) {
+        executed += stats.executed_tasks;
+    }
+    ASSERT_EQUAL(executed, 1100u);
+    executor.ResetStats();
+    ASSERT_EQUAL(executor.GetWorkerStats()[0].executed_tasks, 0u);
+
+    try {
+        executor.ParallelFor(100, [](size_t index) {
+            if (index == 42) {
+                throw out_of_range("42"s);
+            }
+        });
+        ASSERT_HINT(false, "out_of_range expected"s);
+    } catch (const out_of_range&) {
+    }
+
+    SearchServer server("and with"s);
+    int id = 0;
+    for (const string& text : {"funny pet and nasty rat"s, "funny pet with curly hair"s, "big cat nasty hair"s, "big dog cat Vladislav"s, "big dog hamster Borya"s}) {
+        server.AddDocument(++id, text, DocumentStatus::ACTUAL, {id});
+    }
+    const vector<string> queries = {"nasty rat -not"s, "big cat -hair"s, "curly dog"s, "funny"s};
+    const auto expected = ProcessQueries(server, queries);
+    const auto actual = ProcessQueries(executor, server, queries);
+    ASSERT_EQUAL(actual.size(), expected.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const auto documents = server.FindTopDocuments(executor.GetPolicy(), queries[i]);
+        ASSERT_EQUAL(actual[i].size(), expected[i].size());
+        ASSERT_EQUAL(documents.size(), expected[i].size());
+        for (size_t j = 0; j < expected[i].size(); ++j) {
+            ASSERT_EQUAL(actual[i][j].id, expected[i][j].id);
+            ASSERT_EQUAL(documents[j].id, expected[i][j].id);
+            ASSERT(abs(documents[j].relevance - expected[i][j].relevance) < 1e-9);
+        }
+    }
+    ASSERT_EQUAL(ProcessQueriesJoined(executor, server, queries).size(), ProcessQueriesJoined(server, queries).size());
+}
+
+void TestConcurrentSearchServer()
+{
+    ConcurrentSearchServer server(SearchServer("and"s));
+    server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, {1});
+    // До Commit изменения не видны читателям
+    ASSERT_EQUAL(server.GetDocumentCount(), 0);
+    ASSERT_EQUAL(server.GetPendingChangeCount(), 1u);
+    const auto old_snapshot = server.GetSnapshot();
+    server.Commit();
+    ASSERT_EQUAL(server.GetDocumentCount(), 1);
+    ASSERT_EQUAL(server.GetVersion(), 1u);
+    ASSERT_EQUAL(old_snapshot->GetDocumentCount(), 0);
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s).size(), 1u);
+    try {
+        server.AddDocument(1, "black cat"s, DocumentStatus::ACTUAL, {1});
+        ASSERT_HINT(false, "invalid_argument expected"s);
+    } catch (const invalid_argument&) {
+    }
+
+    // Писатели добавляют и удаляют документы, читатели проверяют согласованность каждой версии:
+    // найденные документы должны в ней существовать, а список id - совпадать с числом документов.
+    // Кеш запросов у каждой версии свой, читатели обращаются к нему одновременно
+    SearchServer stress_base("and"s);
+    stress_base.EnableQueryCache(16);
+    ConcurrentSearchServer stress_server(move(stress_base));
+    const int writer_count = 2;
+    const int pair_count = 100;
+    atomic<int> running_writers = writer_count;
+    atomic<int> inconsistent_reads = 0;
+    atomic<int> reads = 0;
+    vector<thread> threads;
+    for (int writer = 0; writer < writer_count; ++writer) {
+        threads.emplace_back([&, writer] {
+            for (int i = 0; i < pair_count; ++i) {
+                const int id = (writer * pair_count + i) * 2;
+                stress_server.AddDocument(id, "common word "s + to_string(i), DocumentStatus::ACTUAL, {i});
+                stress_server.AddDocument(id + 1, "common pair "s + to_string(i), DocumentStatus::ACTUAL, {i});
+                stress_server.Commit();
+                if (i % 3 == 0) {
+                    stress_server.RemoveDocument(id);
+                    stress_server.RemoveDocument(id + 1);
+                    stress_server.Commit();
+                }
+            }
+            --running_writers;
+        });
+    }
+    for (int reader = 0; reader < 3; ++reader) {
+        threads.emplace_back([&] {
+            do {
+                const auto snapshot = stress_server.GetSnapshot();
+                const int document_count = snapshot->GetDocumentCount();
+                const auto documents = snapshot->FindTopDocuments("common"s);
+                if (distance(snapshot->begin(), snapshot->end()) != document_count
+                    || documents.size() != min<size_t>(document_count, MAX_RESULT_DOCUMENT_COUNT)) {
+                    ++inconsistent_reads;
+                }
+                for (const Document& document : documents) {
+                    if (snapshot->GetWordFrequencies(document.id).count("common"sv) == 0) {
+                        ++inconsistent_reads;
+                    }
+                }
+                ++reads;
+            } while (running_writers > 0);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQUAL(inconsistent_reads.load(), 0);
+    ASSERT(reads > 0);
+    ASSERT_EQUAL(stress_server.GetDocumentCount(), writer_count * (pair_count - (pair_count + 2) / 3) * 2);
+}
+
+void TestSegmentedSearchServer()
+{
+    // Результаты и релевантность совпадают с одним SearchServer, сколько бы ни было сегментов
+    mt19937 generator(7);
+    const vector<string> words = {"cat"s, "dog"s, "bird"s, "fish"s, "white"s, "black"s, "big"s, "small"s, "and"s};
+    SearchServer reference("and"s);
+    SegmentedSearchServer segmented("and"s, 10, 3);
+    for (int id = 0; id < 500; ++id) {
+        string text;
+        for (int i = 0; i < 6; ++i) {
+            text += words[uniform_int_distribution<size_t>(0, words.size() - 1)(generator)] + " "s;
+        }
+        const DocumentStatus status = id % 7 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        reference.AddDocument(id, text, status, {id % 10});
+        segmented.AddDocument(id, text, status, {id % 10});
+    }
+    segmented.WaitForMerges();
+    ASSERT(segmented.GetSegmentCount() > 1);
+    ASSERT(segmented.GetSegmentCount() < 50);
+    ASSERT_EQUAL(segmented.GetDocumentCount(), 500);
+
+    const auto check = [&](const string& query, DocumentStatus status) {
+        const auto expected = reference.FindTopDocuments(query, status, 20);
+        const auto actual = segmented.FindTopDocuments(query, status, 20);
+        ASSERT_EQUAL(actual.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT(abs(actual[i].relevance - expected[i].relevance) < 1e-9);
+            ASSERT_EQUAL(actual[i].rating, expected[i].rating);
+        }
+    };
+    for (const string& query : {"cat"s, "white dog -fish"s, "big small bird"s, "and"s, "unknown"s}) {
+        check(query, DocumentStatus::ACTUAL);
+        check(query, DocumentStatus::BANNED);
+    }
+
+    // Удалённые документы не попадают в выдачу и выбрасываются при слиянии
+    for (int id = 0; id < 500; id += 2) {
+        segmented.RemoveDocument(id);
+    }
+    ASSERT_EQUAL(segmented.GetDocumentCount(), 250);
+    for (const Document& document : segmented.FindTopDocuments("cat dog bird fish"s, DocumentStatus::ACTUAL, 1000)) {
+        ASSERT_EQUAL(document.id % 2, 1);
+    }
+    segmented.WaitForMerges();
+    segmented.AddDocument(0, "cat again"s, DocumentStatus::ACTUAL, {100});
+    ASSERT_EQUAL(segmented.FindTopDocuments("cat again"s)[0].id, 0);
+    try {
+        segmented.AddDocument(1, "duplicate"s, DocumentStatus::ACTUAL, {});
+        ASSERT_HINT(false, "invalid_argument expected"s);
+    } catch (const invalid_argument&) {
+    }
+}
+
+void TestDeferredRemoval()
+{
+    const vector<string> texts = {"white cat fluffy tail"s, "black dog long tail"s, "white dog"s, "grey parrot"s, "black cat"s, "parrot and dog"s};
+    SearchServer reference("and"s);
+    SearchServer server("and"s);
+    server.SetDeferredRemoval(true);
+    for (int id = 0; id < static_cast<int>(texts.size()); ++id) {
+        reference.AddDocument(id, texts[id], DocumentStatus::ACTUAL, {id});
+        server.AddDocument(id, texts[id], DocumentStatus::ACTUAL, {id});
+    }
+    for (const int id : {0, 3}) {
+        reference.RemoveDocument(id);
+    }
+    server.RemoveDocument(0);
+    server.RemoveDocument(execution::par, 3);
+    server.RemoveDocument(execution::seq, 42);
+    ASSERT_EQUAL(server.GetDocumentCount(), 4);
+    ASSERT(server.GetWordFrequencies(0).empty());
+
+    // До Compact удалённые документы не находятся, хотя ещё учитываются в IDF
+    for (const Document& document : server.FindTopDocuments("white grey parrot cat"s)) {
+        ASSERT(document.id != 0 && document.id != 3);
+    }
+    QueryContext context;
+    for (const Document& document : server.FindTopDocuments(context, "white grey parrot cat"s)) {
+        ASSERT(document.id != 0 && document.id != 3);
+    }
+    // Статистика корпуса считает число документов по тому же множеству, что и частоты слов
+    CorpusStatistics statistics;
+    server.CollectStatistics("white grey parrot cat"s, statistics);
+    ASSERT_EQUAL(statistics.document_count, 6);
+    const auto local = server.FindTopDocuments("white grey parrot cat"s);
+    const auto global = server.FindTopDocuments(statistics, "white grey parrot cat"s, [](int, DocumentStatus, int) { return true; });
+    ASSERT_EQUAL(global.size(), local.size());
+    for (size_t i = 0; i < local.size(); ++i) {
+        ASSERT_EQUAL(global[i].id, local[i].id);
+        ASSERT_EQUAL(global[i].relevance, local[i].relevance);
+    }
+
+    server.Compact();
+    for (const string& query : {"white cat"s, "parrot -dog"s, "tail dog"s, "grey"s}) {
+        const auto expected = reference.FindTopDocuments(query);
+        const auto actual = server.FindTopDocuments(query);
+        ASSERT_EQUAL(actual.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQUAL(actual[i].id, expected[i].id);
+            ASSERT(abs(actual[i].relevance - expected[i].relevance) < 1e-9);
+        }
+    }
+    // "grey" встречался только в удалённом документе и ушёл из словаря вместе с ним
+    ASSERT_EQUAL(server.GetWordFrequencies(5).count("parrot"sv), 1u);
+    const string match_query = "black tail"s;
+    ASSERT_EQUAL(get<0>(server.MatchDocument(match_query, 1)).size(), 2u);
+
+    // Повторное добавление удалённого id и автоматическое сжатие по порогу
+    server.AddDocument(0, "white cat again"s, DocumentStatus::ACTUAL, {7});
+    server.SetDeferredRemoval(true, 0.3);
+    server.RemoveDocument(1);
+    server.RemoveDocument(2);
+    ASSERT_EQUAL(server.GetDocumentCount(), 3);
+    ASSERT_EQUAL(server.FindTopDocuments("white"s).size(), 1u);
+    ASSERT_EQUAL(server.FindTopDocuments("white"s)[0].id, 0);
+
+    // В снимок не попадают вхождения удалённых, но ещё не сжатых документов
+    server.SetDeferredRemoval(true);
+    server.RemoveDocument(0);
+    const string path = "search_server_deferred_test.bin"s;
+    server.SaveSnapshot(path);
+    const SearchServer loaded = SearchServer::LoadSnapshot(path);
+    remove(path.c_str());
+    ASSERT_EQUAL(loaded.GetDocumentCount(), 2);
+    ASSERT(loaded.FindTopDocuments("white again"s).empty());
+    ASSERT_EQUAL(loaded.FindTopDocuments("cat"s).size(), 1u);
+}
+
+void TestRemoveDuplicates()
+{
+    SearchServer server("and with"s);
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    // Те же слова в другом порядке, с повторами и со стоп-словами - дубликаты
+    server.AddDocument(3, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    server.AddDocument(4, "funny pet and curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    server.AddDocument(5, "funny funny pet and nasty nasty rat"s, DocumentStatus::ACTUAL, {1, 2});
+    server.AddDocument(6, "funny pet and not very nasty rat"s, DocumentStatus::ACTUAL, {1, 2});
+    server.AddDocument(7, "very nasty rat and not very funny pet"s, DocumentStatus::ACTUAL, {1, 2});
+    server.AddDocument(8, "pet with rat and rat and rat"s, DocumentStatus::ACTUAL, {1, 2});
+    server.AddDocument(9, "nasty rat with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    server.AddDocument(0, "hair curly pet funny"s, DocumentStatus::ACTUAL, {1, 2});
+
+    // Из группы одинаковых остаётся документ с наименьшим id
+    ASSERT(FindDuplicates(server) == vector<int>({2, 3, 4, 5, 7}));
+    RemoveDuplicates(server);
+    ASSERT(vector<int>(server.begin(), server.end()) == vector<int>({0, 1, 6, 8, 9}));
+    ASSERT(FindDuplicates(server).empty());
+}
+
+void TestFindNearDuplicates()
+{
+    SearchServer server("and"s);
+    server.AddDocument(5, "one two three four five six seven eight nine ten"s, DocumentStatus::ACTUAL, {1});
+    // Одно слово заменено: Жаккар 9/11
+    server.AddDocument(2, "one two three four five six seven eight nine eleven"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(9, "ten nine eight seven six five four three two one and"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(3, "alpha beta gamma delta epsilon zeta eta theta iota kappa"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(7, "alpha beta gamma delta epsilon zeta eta theta iota lambda"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(4, "alpha beta gamma delta one two three four five six"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(1, "completely different words here"s, DocumentStatus::ACTUAL, {1});
+
+    const auto clusters = FindNearDuplicates(server, 0.8);
+    ASSERT(clusters == vector<vector<int>>({{2, 5, 9}, {3, 7}}));
+    ASSERT(FindNearDuplicates(server, 0.95) == vector<vector<int>>({{5, 9}}));
+
+    RemoveNearDuplicates(server, 0.8);
+    ASSERT(vector<int>(server.begin(), server.end()) == vector<int>({1, 2, 3, 4}));
+}
+
+void TestConjunctiveQueryMode()
+{
+    const vector<int> ids = {1, 4, 5, 9, 17, 18, 40, 41, 100};
+    for (size_t from = 0; from <= ids.size(); ++from) {
+        for (int value = 0; value <= 101; ++value) {
+            const size_t expected = max<size_t>(from, lower_bound(ids.begin(), ids.end(), value) - ids.begin());
+            ASSERT_EQUAL(GallopLowerBound(ids, from, value), expected);
+        }
+    }
+
+    mt19937 generator(3);
+    const vector<string> words = {"cat"s, "dog"s, "bird"s, "fish"s, "white"s, "black"s, "big"s, "small"s, "and"s, "rare"s};
+    SearchServer server("and"s);
+    for (int id = 0; id < 300; ++id) {
+        string text;
+        for (int i = 0; i < 5; ++i) {
+            text += words[uniform_int_distribution<size_t>(0, words.size() - 2)(generator)] + " "s;
+        }
+        if (id % 50 == 0) {
+            text += "rare"s;
+        }
+        server.AddDocument(id, text, id % 3 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, {id % 11});
+    }
+    server.SetDeferredRemoval(true);
+    server.RemoveDocument(100);
+
+    // Результат совпадает с поиском в режиме ANY, отфильтрованным по MatchDocument
+    for (const string& query : {"cat dog"s, "white big -fish"s, "rare cat cat"s, "black and small"s, "cat -cat"s, "unknown cat"s, "and"s}) {
+        set<string> plus_words;
+        for (const auto word : SplitIntoWords(query)) {
+            if (word[0] != '-' && word != "and"sv) {
+                plus_words.insert(string(word));
+            }
+        }
+        vector<Document> expected;
+        for (const Document& document : server.FindTopDocuments(query, DocumentStatus::ACTUAL, 1000)) {
+            if (get<0>(server.MatchDocument(query, document.id)).size() == plus_words.size()) {
+                expected.push_back(document);
+            }
+        }
+        auto actual = server.FindTopDocuments(QueryMode::ALL, query, DocumentStatus::ACTUAL, 1000);
+        // При равной релевантности и рейтинге порядок не определён
+        const auto by_id = [](const Document& lhs, const Document& rhs) { return lhs.id < rhs.id; };
+        sort(expected.begin(), expected.end(), by_id);
+        sort(actual.begin(), actual.end(), by_id);
+        ASSERT_EQUAL(actual.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQUAL(actual[i].id, expected[i].id);
+            ASSERT_EQUAL(actual[i].relevance, expected[i].relevance);
+        }
+    }
+
+    // "rare" есть в документах 0, 50, ..., 250; 100 удалён, 0 и 150 заблокированы
+    const auto late = server.FindTopDocuments(QueryMode::ALL, "rare"s, [](int document_id, DocumentStatus, int) { return document_id >= 150; }, 10);
+    ASSERT_EQUAL(late.size(), 3u);
+    const auto banned = server.FindTopDocuments(QueryMode::ALL, "rare"s, DocumentStatus::BANNED, 10);
+    ASSERT_EQUAL(banned.size(), 2u);
+    server.EnableQueryCache(10);
+    ASSERT_EQUAL(server.FindTopDocuments(QueryMode::ALL, "rare cat"s, DocumentStatus::ACTUAL).size(), server.FindTopDocuments(QueryMode::ALL, "rare cat"s).size());
+}
+
+void TestPrunedQueryMode()
+{
+    PostingList postings;
+    postings.Add(3, 0.25);
+    postings.Add(1, 0.5);
+    postings.Add(7, 0.125);
+    ASSERT_EQUAL(postings.GetMaxTermFreq(), 0.5);
+    postings.RemapDocuments({-1, -1, -1, 0, -1, -1, -1, 1});
+    ASSERT_EQUAL(postings.GetMaxTermFreq(), 0.25);
+
+    // Частые и редкие слова вперемешку, как в живом корпусе
+    mt19937 generator(7);
+    vector<string> words;
+    for (int i = 0; i < 60; ++i) {
+        words.push_back("w"s + to_string(i));
+    }
+    SearchServer server("w0"s);
+    for (int id = 0; id < 2000; ++id) {
+        string text;
+        const int word_count = uniform_int_distribution(1, 12)(generator);
+        for (int i = 0; i < word_count; ++i) {
+            const size_t frequent = uniform_int_distribution<size_t>(0, 5)(generator);
+            const size_t any = uniform_int_distribution<size_t>(0, words.size() - 1)(generator);
+            text += words[min(frequent, any)] + " "s;
+        }
+        // Рейтинги различны, поэтому порядок выдачи определён однозначно
+        server.AddDocument(id, text, id % 7 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, {id});
+    }
+    // Копии документов: равная релевантность, решает рейтинг
+    server.AddDocument(5000, "w1 w2 w3"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(5001, "w1 w2 w3"s, DocumentStatus::ACTUAL, {2});
+    server.SetDeferredRemoval(true);
+    server.RemoveDocument(10);
+    server.RemoveDocument(11);
+
+    const auto check = [](const vector<Document>& actual, const vector<Document>& expected) {
+        ASSERT_EQUAL(actual.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQUAL(actual[i].id, expected[i].id);
+            ASSERT_EQUAL(actual[i].relevance, expected[i].relevance);
+            ASSERT_EQUAL(actual[i].rating, expected[i].rating);
+        }
+    };
+    for (const string& query : {"w1 w2"s, "w1 w2 w3 w4 w5"s, "w1 w40 w59"s, "w3 -w1"s, "w2 w5 -w1 -w4"s, "w0 w1"s, "w1 w1 w33"s, "unknown w7"s, "w0"s}) {
+        for (const size_t max_count : {0u, 1u, 5u, 20u, 5000u}) {
+            check(server.FindTopDocuments(QueryMode::ANY_PRUNED, query, DocumentStatus::ACTUAL, max_count),
+                  server.FindTopDocuments(query, DocumentStatus::ACTUAL, max_count));
+            check(server.FindTopDocuments(QueryMode::ANY_PRUNED, query, DocumentStatus::BANNED, max_count),
+                  server.FindTopDocuments(query, DocumentStatus::BANNED, max_count));
+        }
+        const auto even = [](int document_id, DocumentStatus, int) { return document_id % 2 == 0; };
+        check(server.FindTopDocuments(QueryMode::ANY_PRUNED, query, even), server.FindTopDocuments(query, even));
+    }
+    for (int i = 0; i < 200; ++i) {
+        string query;
+        for (int j = uniform_int_distribution(1, 6)(generator); j > 0; --j) {
+            query += words[uniform_int_distribution<size_t>(1, words.size() - 1)(generator)] + " "s;
+        }
+        query.pop_back();
+        check(server.FindTopDocuments(QueryMode::ANY_PRUNED, query), server.FindTopDocuments(query));
+    }
+}
+
+void TestMinusWordExclusion()
+{
+    DocumentBitmap bitmap(130);
+    for (const int document_index : {0, 63, 64, 129}) {
+        bitmap.Set(document_index);
+    }
+    for (int document_index = 0; document_index < 130; ++document_index) {
+        ASSERT_EQUAL(bitmap.Test(document_index), document_index == 0 || document_index == 63 || document_index == 64 || document_index == 129);
+    }
+
+    SearchServer server(""s);
+    for (int id = 0; id < 200; ++id) {
+        string text = "cat"s;
+        if (id % 2 == 0) {
+            text += " dog"s;
+        }
+        if (id % 3 == 0) {
+            text += " bird"s;
+        }
+        server.AddDocument(id, text, DocumentStatus::ACTUAL, {id});
+    }
+    QueryExecutor executor(2);
+    // Остаются документы без "dog" и "bird": id, не делящиеся ни на 2, ни на 3
+    for (const auto& documents : {server.FindTopDocuments("cat -dog -bird"s, DocumentStatus::ACTUAL, 1000),
+                                  server.FindTopDocuments(execution::par, "cat -dog -bird"s, DocumentStatus::ACTUAL, 1000),
+                                  server.FindTopDocuments(executor.GetPolicy(), "cat -dog -bird"s, DocumentStatus::ACTUAL, 1000)}) {
+        ASSERT_EQUAL(documents.size(), 67u);
+        for (const Document& document : documents) {
+            ASSERT(document.id % 2 != 0 && document.id % 3 != 0);
+        }
+    }
+    ASSERT(server.FindTopDocuments("cat -cat"s).empty());
+    ASSERT_EQUAL(server.FindTopDocuments("cat -unknown"s, DocumentStatus::ACTUAL, 1000).size(), 200u);
+}
+
+void TestCompressedPostingList()
+{
+    mt19937 generator(11);
+    for (const size_t size : {0u, 1u, 3u, 128u, 129u, 1000u}) {
+        vector<int> document_ids;
+        vector<uint32_t> term_counts;
+        int document_id = 0;
+        for (size_t i = 0; i < size; ++i) {
+            // Разности всех длин: от 1 до 4 байт
+            const int shift = uniform_int_distribution(0, 24)(generator);
+            document_id += 1 + uniform_int_distribution(0, (1 << shift) - 1)(generator) % 100'000'000;
+            document_ids.push_back(i == 0 ? 0 : document_id);
+            term_counts.push_back(uniform_int_distribution<uint32_t>(1, i % 7 == 0 ? 100'000 : 3)(generator));
+        }
+        const CompressedPostingList postings(document_ids, term_counts);
+        ASSERT_EQUAL(postings.size(), size);
+
+        for (const SimdLevel level : {SimdLevel::SCALAR, GetBestSimdLevel()}) {
+            vector<int> decoded_ids;
+            vector<uint32_t> decoded_counts;
+            for (CompressedPostingCursor cursor(postings, level); cursor.IsValid(); cursor.Next()) {
+                decoded_ids.push_back(cursor.GetDocumentId());
+                decoded_counts.push_back(cursor.GetTermCount());
+            }
+            ASSERT(decoded_ids == document_ids);
+            ASSERT(decoded_counts == term_counts);
+        }
+
+        // SkipTo совпадает с lower_bound, в том числе через несколько блоков
+        CompressedPostingCursor cursor(postings);
+        for (int target = 0; !document_ids.empty() && target <= document_ids.back() + 1; target += max(1, document_ids.back() / 300)) {
+            cursor.SkipTo(target);
+            const auto it = lower_bound(document_ids.begin(), document_ids.end(), target);
+            ASSERT_EQUAL(cursor.IsValid(), it != document_ids.end());
+            if (cursor.IsValid()) {
+                ASSERT_EQUAL(cursor.GetDocumentId(), *it);
+                ASSERT_EQUAL(cursor.GetTermCount(), term_counts[it - document_ids.begin()]);
+            }
+        }
+    }
+}
+
+void TestForwardIndex()
+{
+    TermDictionary terms;
+    for (const string_view word : {"bird"sv, "cat"sv, "dog"sv}) {
+        terms.Intern(word);
+    }
+    ForwardIndex index;
+    index.AddDocument();
+    index.AddTerm(1, 0.5);
+    index.AddTerm(2, 0.5);
+    index.AddDocument();
+    index.AddTerm(0, 1.0);
+    index.AddDocument();
+    index.AddTerm(1, 0.25);
+    index.AddTerm(2, 0.75);
+
+    using WordList = vector<pair<string_view, double>>;
+    const auto to_list = [](const WordFrequenciesView& words) {
+        return WordList(words.begin(), words.end());
+    };
+    const WordList expected = {{"cat"sv, 0.25}, {"dog"sv, 0.75}};
+    const auto words = index.GetWordFrequencies(2, terms);
+    ASSERT_EQUAL(words.size(), 2u);
+    ASSERT_EQUAL(words.count("dog"sv), 1u);
+    ASSERT_EQUAL(words.count("bird"sv), 0u);
+    ASSERT(to_list(words) == expected);
+
+    // Документ 1 удалён, слово "bird" больше не встречается: "cat" получает id 0, "dog" - 1
+    index.ClearDocument(1);
+    ASSERT(index.GetWordFrequencies(1, terms).empty());
+    index.RemapDocuments({0, -1, 1});
+    TermDictionary new_terms;
+    new_terms.Intern("cat"sv);
+    new_terms.Intern("dog"sv);
+    index.RemapTerms({-1, 0, 1});
+    ASSERT(to_list(index.GetWordFrequencies(1, new_terms)) == expected);
+    ASSERT_EQUAL(index.GetWordFrequencies(0, new_terms).count("cat"sv), 1u);
+}
+
+void TestRelevancePrecision()
+{
+    // Эталон: релевантность считается заново в double по текстам документов,
+    // порядок выдачи должен совпадать при любом типе Relevance
+    const auto check_corpus = [](const vector<vector<string>>& texts, const vector<string>& queries) {
+        SearchServer server("w0"s);
+        vector<map<string, int>> document_words(texts.size());
+        vector<int> document_lengths(texts.size(), 0);
+        map<string, int> document_freqs;
+        for (int id = 0; id < static_cast<int>(texts.size()); ++id) {
+            string text;
+            for (const string& word : texts[id]) {
+                text += (text.empty() ? ""s : " "s) + word;
+                if (word != "w0"s) {
+                    document_freqs[word] += document_words[id][word]++ == 0 ? 1 : 0;
+                    ++document_lengths[id];
+                }
+            }
+            // Рейтинги различны: при равной релевантности порядок однозначен
+            server.AddDocument(id, text, DocumentStatus::ACTUAL, {id});
+        }
+
+        for (const string& query : queries) {
+            vector<string> plus_words;
+            vector<string> minus_words;
+            for (const string_view word : SplitIntoWords(query)) {
+                if (word[0] == '-') {
+                    minus_words.push_back(string(word.substr(1)));
+                } else {
+                    plus_words.push_back(string(word));
+                }
+            }
+            sort(plus_words.begin(), plus_words.end());
+            plus_words.erase(unique(plus_words.begin(), plus_words.end()), plus_words.end());
+
+            vector<pair<double, int>> expected;
+            for (int id = 0; id < static_cast<int>(texts.size()); ++id) {
+                const auto& counts = document_words[id];
+                if (any_of(minus_words.begin(), minus_words.end(), [&counts](const string& word) { return counts.count(word) > 0; })) {
+                    continue;
+                }
+                double relevance = 0.0;
+                bool matched = false;
+                for (const string& word : plus_words) {
+                    const auto it = counts.find(word);
+                    if (it == counts.end()) {
+                        continue;
+                    }
+                    relevance += static_cast<double>(it->second) / document_lengths[id] * log(static_cast<double>(texts.size()) / document_freqs.at(word));
+                    matched = true;
+                }
+                if (matched) {
+                    expected.push_back({relevance, id});
+                }
+            }
+            sort(expected.begin(), expected.end(), [](const auto& lhs, const auto& rhs) {
+                if (abs(lhs.first - rhs.first) < GetRelevanceTolerance(static_cast<Relevance>(max(abs(lhs.first), abs(rhs.first))))) {
+                    return lhs.second > rhs.second;
+                }
+                return lhs.first > rhs.first;
+            });
+            expected.resize(min<size_t>(expected.size(), MAX_RESULT_DOCUMENT_COUNT));
+
+            const auto documents = server.FindTopDocuments(query);
+            ASSERT_EQUAL(documents.size(), expected.size());
+            for (size_t j = 0; j < expected.size(); ++j) {
+                ASSERT_EQUAL(documents[j].id, expected[j].second);
+                ASSERT(abs(documents[j].relevance - expected[j].first) < 1e-5 * max(1.0, expected[j].first));
+            }
+        }
+    };
+
+    // Частые слова и низкие IDF (до ln 1000)
+    mt19937 generator(5);
+    vector<string> words;
+    for (int i = 0; i < 40; ++i) {
+        words.push_back("w"s + to_string(i));
+    }
+    vector<vector<string>> texts(1000);
+    for (auto& text : texts) {
+        for (int i = uniform_int_distribution(5, 30)(generator); i > 0; --i) {
+            text.push_back(words[min(uniform_int_distribution<size_t>(0, 3)(generator), uniform_int_distribution<size_t>(0, words.size() - 1)(generator))]);
+        }
+    }
+    vector<string> queries;
+    for (int i = 0; i < 100; ++i) {
+        string query;
+        for (int j = uniform_int_distribution(1, 5)(generator); j > 0; --j) {
+            query += (query.empty() ? ""s : " "s) + (uniform_int_distribution(0, 5)(generator) == 0 ? "-"s : ""s)
+                + words[uniform_int_distribution<size_t>(1, words.size() - 1)(generator)];
+        }
+        queries.push_back(query);
+    }
+    check_corpus(texts, queries);
+
+    // Высокие IDF (до ln 20000 ~ 9.9, где шаг float близок к 1e-6). Документ - 6 разных слов с частотами
+    // d1..d6, по запросу со всеми словами его релевантность ln N - ln(d1 * ... * d6) / 6, поэтому документы
+    // с одинаковым произведением частот равны точно, но во float расходятся на одну-две единицы
+    // последнего разряда. Порядок среди них решает рейтинг.
+    constexpr int MAX_DOCUMENT_FREQ = 8;
+    map<int, vector<array<int, 6>>> freqs_by_product;
+    for (array<int, 6> freqs = {1, 1, 1, 1, 1, 1};;) {
+        int product = 1;
+        for (const int freq : freqs) {
+            product *= freq;
+        }
+        freqs_by_product[product].push_back(freqs);
+        // Следующий неубывающий набор
+        int i = 5;
+        while (i >= 0 && freqs[i] == MAX_DOCUMENT_FREQ) {
+            --i;
+        }
+        if (i < 0) {
+            break;
+        }
+        fill(freqs.begin() + i, freqs.end(), freqs[i] + 1);
+    }
+    texts.assign(20000, {"filler"s});
+    queries.clear();
+    size_t next_document = 0;
+    for (auto it = freqs_by_product.lower_bound(700); it != freqs_by_product.end() && next_document < 12000; ++it) {
+        if (it->second.size() < 2) {
+            continue;
+        }
+        string query;
+        for (size_t group = 0; group < it->second.size(); ++group) {
+            vector<string> document;
+            for (size_t k = 0; k < 6; ++k) {
+                const string word = "t"s + to_string(it->first) + "_"s + to_string(group) + "_"s + to_string(k);
+                document.push_back(word);
+                // Остальные вхождения - в документах с другим словом, их релевантность ниже
+                for (int i = 1; i < it->second[group][k]; ++i) {
+                    texts[next_document++] = {word, "filler"s};
+                }
+                query += (query.empty() ? ""s : " "s) + word;
+            }
+            texts[next_document++] = document;
+        }
+        queries.push_back(query);
+    }
+    check_corpus(texts, queries);
+}
+
+void TestScoringKernel()
+{
+    mt19937 generator(25);
+    const int document_count = 5000;
+    uniform_real_distribution<double> random_freq(0.001, 1.0);
+    for (const size_t count : {0u, 1u, 7u, 15u, 17u, 256u}) {
+        // Несколько слов подряд копят релевантность в общем буфере, как при поиске
+        vector<Relevance> expected(document_count, 0);
+        vector<vector<Relevance>> actual(4, vector<Relevance>(document_count, 0));
+        for (int word = 0; word < 3; ++word) {
+            vector<int> document_ids(document_count);
+            iota(document_ids.begin(), document_ids.end(), 0);
+            shuffle(document_ids.begin(), document_ids.end(), generator);
+            document_ids.resize(count);
+            sort(document_ids.begin(), document_ids.end());
+            vector<Relevance> term_freqs(count);
+            for (Relevance& term_freq : term_freqs) {
+                term_freq = static_cast<Relevance>(random_freq(generator));
+            }
+            const Relevance inverse_document_freq = static_cast<Relevance>(random_freq(generator) * 10);
+            AccumulateScores(SimdLevel::SCALAR, document_ids.data(), term_freqs.data(), count, inverse_document_freq, expected.data());
+            for (const SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512}) {
+                AccumulateScores(level, document_ids.data(), term_freqs.data(), count, inverse_document_freq, actual[static_cast<int>(level)].data());
+            }
+        }
+        // Без FMA результат совпадает побитово, а не с точностью до погрешности
+        for (const auto& scores : actual) {
+            ASSERT(scores == expected);
+        }
+    }
+
+    // Поиск с QueryContext, где подсчёт идёт через ядро, выдаёт то же, что и обычный
+    SearchServer server(""s);
+    const vector<string> words = {"cat"s, "dog"s, "bird"s, "fish"s, "tail"s, "white"s, "black"s};
+    for (int id = 0; id < 2000; ++id) {
+        string text;
+        const int length = uniform_int_distribution(1, 8)(generator);
+        for (int i = 0; i < length; ++i) {
+            text += words[uniform_int_distribution<size_t>(0, words.size() - 1)(generator)] + " "s;
+        }
+        text.pop_back();
+        server.AddDocument(id, text, id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, {id % 17});
+    }
+    server.RemoveDocument(7);
+    QueryContext context;
+    for (const string& query : {"cat"s, "cat dog bird"s, "white tail -fish"s, "black -cat -dog"s}) {
+        for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED}) {
+            // Документы с равными релевантностью и рейтингом упорядочены произвольно: сравниваются множества
+            const auto to_set = [](const vector<Document>& documents) {
+                set<pair<int, Relevance>> result;
+                for (const Document& document : documents) {
+                    result.insert({document.id, document.relevance});
+                }
+                return result;
+            };
+            const auto expected = server.FindTopDocuments(query, status, 2000);
+            const auto actual = server.FindTopDocuments(context, query, status, 2000);
+            ASSERT_EQUAL(actual.size(), expected.size());
+            ASSERT(to_set(actual) == to_set(expected));
+        }
+    }
+}
+
+void TestFrozenSegment()
+{
+    // Повторы слов и стоп-слова: TF восстанавливается из числа вхождений и длины документа
+    mt19937 generator(22);
+    const vector<string> words = {"cat"s, "dog"s, "bird"s, "fish"s, "tail"s, "white"s, "black"s, "and"s};
+    SearchServer server("and"s);
+    for (int id = 0; id < 700; ++id) {
+        string text;
+        const int length = uniform_int_distribution(1, 40)(generator);
+        for (int i = 0; i < length; ++i) {
+            text += words[uniform_int_distribution<size_t>(0, words.size() - 1)(generator)] + " "s;
+        }
+        text.pop_back();
+        server.AddDocument(id, text, id % 3 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, {id % 11});
+    }
+    server.RemoveDocument(5);
+    server.RemoveDocument(6);
+    const FrozenSegment segment(server);
+    ASSERT_EQUAL(segment.GetDocumentCount(), server.GetDocumentCount());
+    ASSERT(segment.MemoryUsage() < server.MemoryUsage());
+
+    // Документы с равными релевантностью и рейтингом упорядочены произвольно: сравниваются множества
+    const auto to_set = [](const vector<Document>& documents) {
+        set<tuple<int, Relevance, int>> result;
+        for (const Document& document : documents) {
+            result.insert({document.id, document.relevance, document.rating});
+        }
+        return result;
+    };
+    const auto check = [&](const FrozenSegment& frozen, const SearchServer& expected_server, const string& query,
+                            const vector<string_view>& plus_words, const vector<string_view>& minus_words) {
+        CorpusStatistics statistics;
+        expected_server.CollectStatistics(query, statistics);
+        CorpusStatistics segment_statistics;
+        frozen.CollectStatistics(plus_words, segment_statistics);
+        ASSERT_EQUAL(segment_statistics.document_count, statistics.document_count);
+        ASSERT(segment_statistics.document_freqs == statistics.document_freqs);
+        const auto predicate = [](int document_id, DocumentStatus status, int) {
+            return status == DocumentStatus::ACTUAL && document_id % 7 != 0;
+        };
+        const auto expected = expected_server.FindTopDocuments(statistics, query, predicate, 1000);
+        const auto actual = frozen.FindTopDocuments(statistics, plus_words, minus_words, predicate, 1000);
+        ASSERT_EQUAL(actual.size(), expected.size());
+        ASSERT(to_set(actual) == to_set(expected));
+    };
+    check(segment, server, "cat"s, {"cat"sv}, {});
+    check(segment, server, "cat dog -fish"s, {"cat"sv, "dog"sv}, {"fish"sv});
+    check(segment, server, "white black tail -cat -unknown"s, {"black"sv, "tail"sv, "white"sv}, {"cat"sv, "unknown"sv});
+
+    // Слияние сегментов без удалённых документов совпадает с индексом из тех же документов
+    SearchServer first("and"s);
+    SearchServer second("and"s);
+    SearchServer merged_expected("and"s);
+    for (int id = 0; id < 300; ++id) {
+        const string text = words[id % 7] + " "s + words[(id / 7) % 7] + " and "s + words[id % 5];
+        (id < 150 ? first : second).AddDocument(id, text, DocumentStatus::ACTUAL, {id % 4});
+        if (id % 10 != 0) {
+            merged_expected.AddDocument(id, text, DocumentStatus::ACTUAL, {id % 4});
+        }
+    }
+    set<int> first_deleted;
+    set<int> second_deleted;
+    for (int id = 0; id < 300; id += 10) {
+        (id < 150 ? first_deleted : second_deleted).insert(id);
+    }
+    const FrozenSegment first_segment(first);
+    const FrozenSegment second_segment(second);
+    const FrozenSegment merged({{&first_segment, &first_deleted}, {&second_segment, &second_deleted}});
+    ASSERT_EQUAL(merged.GetDocumentCount(), 270);
+    check(merged, merged_expected, "cat tail"s, {"cat"sv, "tail"sv}, {});
+    check(merged, merged_expected, "dog -bird"s, {"dog"sv}, {"bird"sv});
+
+    // Длинный документ с перекосом: длина берётся из индекса, а не подбирается по TF
+    string skewed;
+    for (int i = 0; i < 65537; ++i) {
+        skewed += "a "s;
+    }
+    for (int i = 0; i < 65538; ++i) {
+        skewed += "b "s;
+    }
+    SearchServer long_server(""s);
+    long_server.AddDocument(1, skewed, DocumentStatus::ACTUAL, {1});
+    long_server.AddDocument(2, "a c"s, DocumentStatus::ACTUAL, {2});
+    const FrozenSegment long_segment(long_server);
+    check(long_segment, long_server, "a b"s, {"a"sv, "b"sv}, {});
+    check(long_segment, long_server, "b -c"s, {"b"sv}, {"c"sv});
+    SegmentedSearchServer segmented(""s, 1);
+    segmented.AddDocument(1, skewed, DocumentStatus::ACTUAL, {1});
+    segmented.AddDocument(2, "a c"s, DocumentStatus::ACTUAL, {2});
+    ASSERT_EQUAL(segmented.GetDocumentCount(), 2);
+    ASSERT_EQUAL(segmented.FindTopDocuments("a"s).size(), 2u);
+}
+
+void TestImmediateRemovalReclaimsMemory()
+{
+    // Поток добавлений и удалений: память не растёт с числом удалённых документов
+    SearchServer server("and"s);
+    const auto make_text = [](int id) {
+        return "word"s + to_string(id % 97) + " and cat "s + "unique"s + to_string(id);
+    };
+    const int window = 500;
+    for (int id = 0; id < window; ++id) {
+        server.AddDocument(id, make_text(id), DocumentStatus::ACTUAL, {id % 5});
+    }
+    const size_t initial_memory = server.MemoryUsage();
+    for (int id = window; id < 20 * window; ++id) {
+        server.RemoveDocument(id - window);
+        server.AddDocument(id, make_text(id), DocumentStatus::ACTUAL, {id % 5});
+    }
+    ASSERT_EQUAL(server.GetDocumentCount(), window);
+    ASSERT(server.MemoryUsage() < 3 * initial_memory);
+
+    // После сжатия поиск и слова документов не изменились
+    const int last_id = 20 * window - 1;
+    ASSERT_EQUAL(server.GetWordFrequencies(last_id).size(), 3u);
+    ASSERT(server.GetWordFrequencies(0).empty());
+    const auto found = server.FindTopDocuments("unique"s + to_string(last_id));
+    ASSERT_EQUAL(found.size(), 1u);
+    ASSERT_EQUAL(found[0].id, last_id);
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 1000).size(), static_cast<size_t>(window));
+}
+
 /*
         Разместите код остальных тестов здесь
         */
@@ -273,6 +1687,33 @@ void TestSearchServer() {
     RUN_TEST(TestMatchMinusWords);
     RUN_TEST(FindDocStatus);
     RUN_TEST(TestUSersPredicate);
+    RUN_TEST(TestPostingListOrder);
+    RUN_TEST(TestTopDocumentsCount);
+    RUN_TEST(TestScoreTable);
+    RUN_TEST(TestRemoveAndReAddDocument);
+    RUN_TEST(TestAddDocuments);
+    RUN_TEST(TestSnapshotRoundTrip);
+    RUN_TEST(TestTermDictionary);
+    RUN_TEST(TestRelevanceTracksIndexChanges);
+    RUN_TEST(TestQueryCache);
+    RUN_TEST(TestQueryContextDoesNotAllocate);
+    RUN_TEST(TestSplitIntoWordsImplementations);
+    RUN_TEST(TestProcessQueriesStream);
+    RUN_TEST(TestQueryExecutor);
+    RUN_TEST(TestConcurrentSearchServer);
+    RUN_TEST(TestSegmentedSearchServer);
+    RUN_TEST(TestDeferredRemoval);
+    RUN_TEST(TestRemoveDuplicates);
+    RUN_TEST(TestFindNearDuplicates);
+    RUN_TEST(TestConjunctiveQueryMode);
+    RUN_TEST(TestPrunedQueryMode);
+    RUN_TEST(TestMinusWordExclusion);
+    RUN_TEST(TestCompressedPostingList);
+    RUN_TEST(TestForwardIndex);
+    RUN_TEST(TestRelevancePrecision);
+    RUN_TEST(TestScoringKernel);
+    RUN_TEST(TestFrozenSegment);
+    RUN_TEST(TestImmediateRemovalReclaimsMemory);
     // Не забудьте вызывать остальные тесты здесь
 }
 
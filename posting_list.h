@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "document.h"
+
+// Первая позиция не раньше from, где document_ids[pos] >= document_id, или document_ids.size().
+// Шаг растёт вдвое, пока не перескочит искомый id, затем двоичный поиск в последнем шаге:
+// при последовательных запросах по возрастанию стоимость зависит от расстояния, а не от длины списка.
+inline size_t GallopLowerBound(const std::vector<int>& document_ids, size_t from, int document_id)
+{
+    size_t bound = from;
+    for (size_t step = 1; bound < document_ids.size() && document_ids[bound] < document_id; step *= 2) {
+        from = bound + 1;
+        bound += step;
+    }
+    const auto last = document_ids.begin() + std::min(bound, document_ids.size());
+    return std::lower_bound(document_ids.begin() + from, last, document_id) - document_ids.begin();
+}
+
+// Список вхождений слова: отсортированные id документов и параллельный массив TF.
+// Хранится непрерывно, поэтому обход при ранжировании идёт подряд по памяти.
+// Наибольший TF списка - верхняя граница вклада слова в релевантность для отсечения (MaxScore).
+class PostingList {
+public:
+    PostingList() = default;
+
+    PostingList(const int* document_ids, const Relevance* term_freqs, size_t size)
+        : document_ids_(document_ids, document_ids + size)
+        , term_freqs_(term_freqs, term_freqs + size)
+    {
+        UpdateMaxTermFreq();
+    }
+
+    void Add(int document_id, Relevance term_freq)
+    {
+        if (document_ids_.empty() || document_ids_.back() < document_id) {
+            document_ids_.push_back(document_id);
+            term_freqs_.push_back(term_freq);
+            max_term_freq_ = std::max(max_term_freq_, term_freq);
+            return;
+        }
+        const auto it = std::lower_bound(document_ids_.begin(), document_ids_.end(), document_id);
+        const auto pos = it - document_ids_.begin();
+        if (it != document_ids_.end() && *it == document_id) {
+            term_freqs_[pos] += term_freq;
+        } else {
+            document_ids_.insert(it, document_id);
+            term_freqs_.insert(term_freqs_.begin() + pos, term_freq);
+        }
+        max_term_freq_ = std::max(max_term_freq_, term_freqs_[pos]);
+    }
+
+    // После Erase граница не уменьшается: она остаётся верной, а уточняется при RemapDocuments
+    bool Erase(int document_id)
+    {
+        const auto it = std::lower_bound(document_ids_.begin(), document_ids_.end(), document_id);
+        if (it == document_ids_.end() || *it != document_id) {
+            return false;
+        }
+        term_freqs_.erase(term_freqs_.begin() + (it - document_ids_.begin()));
+        document_ids_.erase(it);
+        return true;
+    }
+
+    // Перенумерация документов по new_document_ids; -1 - вхождение удаляется.
+    // Нумерация должна сохранять порядок, тогда список остаётся отсортированным.
+    void RemapDocuments(const std::vector<int>& new_document_ids)
+    {
+        size_t size = 0;
+        for (size_t i = 0; i < document_ids_.size(); ++i) {
+            const int document_id = new_document_ids[document_ids_[i]];
+            if (document_id >= 0) {
+                document_ids_[size] = document_id;
+                term_freqs_[size] = term_freqs_[i];
+                ++size;
+            }
+        }
+        document_ids_.resize(size);
+        term_freqs_.resize(size);
+        document_ids_.shrink_to_fit();
+        term_freqs_.shrink_to_fit();
+        UpdateMaxTermFreq();
+    }
+
+    bool Contains(int document_id) const
+    {
+        return std::binary_search(document_ids_.begin(), document_ids_.end(), document_id);
+    }
+
+    size_t size() const
+    {
+        return document_ids_.size();
+    }
+
+    bool empty() const
+    {
+        return document_ids_.empty();
+    }
+
+    const std::vector<int>& GetDocumentIds() const
+    {
+        return document_ids_;
+    }
+
+    const std::vector<Relevance>& GetTermFreqs() const
+    {
+        return term_freqs_;
+    }
+
+    Relevance GetMaxTermFreq() const
+    {
+        return max_term_freq_;
+    }
+
+    size_t MemoryUsage() const
+    {
+        return sizeof(*this)
+            + document_ids_.capacity() * sizeof(int)
+            + term_freqs_.capacity() * sizeof(Relevance);
+    }
+
+private:
+    std::vector<int> document_ids_;
+    std::vector<Relevance> term_freqs_;
+    Relevance max_term_freq_ = 0.0;
+
+    void UpdateMaxTermFreq()
+    {
+        max_term_freq_ = term_freqs_.empty() ? Relevance{0} : *std::max_element(term_freqs_.begin(), term_freqs_.end());
+    }
+};
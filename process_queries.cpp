@@ -1,10 +1,133 @@
 #include "process_queries.h"
 
 #include <algorithm>
+#include <condition_variable>
+#include <exception>
 #include <execution>
+#include <mutex>
+#include <thread>
 
 using namespace std;
 
+namespace {
+
+// Кольцо из depth ячеек: вызывающий поток читает запросы в свободные ячейки и выдаёт
+// готовые результаты по порядку, рабочие потоки забирают прочитанные запросы.
+// Запрос с номером i всегда лежит в ячейке i % depth.
+class QueryPipeline {
+public:
+    QueryPipeline(const SearchServer& search_server, size_t depth)
+        : search_server_(search_server)
+        , slots_(depth)
+    {
+        const size_t worker_count = min<size_t>(depth, max(1u, thread::hardware_concurrency()));
+        workers_.reserve(worker_count);
+        for (size_t i = 0; i < worker_count; ++i) {
+            workers_.emplace_back([this] { Work(); });
+        }
+    }
+
+    QueryPipeline(const QueryPipeline&) = delete;
+    QueryPipeline& operator=(const QueryPipeline&) = delete;
+
+    ~QueryPipeline()
+    {
+        {
+            lock_guard lock(mutex_);
+            stopped_ = true;
+        }
+        work_ready_.notify_all();
+        for (thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    void Run(const QuerySource& source, const QueryResultSink& sink)
+    {
+        bool source_exhausted = false;
+        while (true) {
+            // Пока есть свободные ячейки, читаем запросы: ячейку read_count_ никто не занимает
+            if (!source_exhausted && read_count_ - delivered_count_ < slots_.size()) {
+                Slot& slot = slots_[read_count_ % slots_.size()];
+                if (source(slot.query)) {
+                    {
+                        lock_guard lock(mutex_);
+                        ++read_count_;
+                    }
+                    work_ready_.notify_one();
+                    continue;
+                }
+                source_exhausted = true;
+            }
+            if (delivered_count_ == read_count_) {
+                return;
+            }
+
+            Slot& slot = slots_[delivered_count_ % slots_.size()];
+            {
+                unique_lock lock(mutex_);
+                result_ready_.wait(lock, [&slot] { return slot.done; });
+                slot.done = false;
+            }
+            if (slot.error) {
+                rethrow_exception(exchange(slot.error, nullptr));
+            }
+            sink(delivered_count_, slot.result);
+            // Ячейка освобождается только после sink, поэтому результат не копируется
+            ++delivered_count_;
+        }
+    }
+
+private:
+    struct Slot {
+        string query;
+        vector<Document> result;
+        exception_ptr error;
+        bool done = false;
+    };
+
+    const SearchServer& search_server_;
+    vector<Slot> slots_;
+    vector<thread> workers_;
+
+    mutex mutex_;
+    condition_variable work_ready_;
+    condition_variable result_ready_;
+    bool stopped_ = false;
+    size_t read_count_ = 0;
+    size_t claimed_count_ = 0;
+    // Меняется только вызывающим потоком
+    size_t delivered_count_ = 0;
+
+    void Work()
+    {
+        while (true) {
+            size_t index;
+            {
+                unique_lock lock(mutex_);
+                work_ready_.wait(lock, [this] { return stopped_ || claimed_count_ < read_count_; });
+                if (stopped_) {
+                    return;
+                }
+                index = claimed_count_++;
+            }
+            Slot& slot = slots_[index % slots_.size()];
+            try {
+                slot.result = search_server_.FindTopDocuments(slot.query);
+            } catch (...) {
+                slot.error = current_exception();
+            }
+            {
+                lock_guard lock(mutex_);
+                slot.done = true;
+            }
+            result_ready_.notify_one();
+        }
+    }
+};
+
+} // namespace
+
 vector<vector<Document>> ProcessQueries(const SearchServer& search_server, const vector<string>& queries)
 {
     vector<vector<Document>> result(queries.size());
@@ -16,10 +139,45 @@ vector<vector<Document>> ProcessQueries(const SearchServer& search_server, const
 }
 
 vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const vector<string>& queries)
+{
+    // Результаты дописываются по мере готовности, без промежуточного vector<vector<Document>>
+    vector<Document> result;
+    ProcessQueriesStream(search_server, queries.begin(), queries.end(), [&result](size_t, const vector<Document>& documents) {
+        result.insert(result.end(), documents.begin(), documents.end());
+    });
+    return result;
+}
+
+vector<vector<Document>> ProcessQueries(QueryExecutor& executor, const SearchServer& search_server, const vector<string>& queries)
+{
+    vector<vector<Document>> result(queries.size());
+    executor.ParallelFor(queries.size(), [&](size_t index) {
+        result[index] = search_server.FindTopDocuments(queries[index]);
+    });
+    return result;
+}
+
+vector<Document> ProcessQueriesJoined(QueryExecutor& executor, const SearchServer& search_server, const vector<string>& queries)
 {
     vector<Document> result;
-    for (const auto& query_response : ProcessQueries(search_server, queries)) {
+    for (const auto& query_response : ProcessQueries(executor, search_server, queries)) {
         result.insert(result.end(), query_response.begin(), query_response.end());
     }
     return result;
 }
+
+void ProcessQueriesStream(const SearchServer& search_server, const QuerySource& source, const QueryResultSink& sink, size_t pipeline_depth)
+{
+    if (pipeline_depth == 0) {
+        pipeline_depth = 4 * static_cast<size_t>(max(1u, thread::hardware_concurrency()));
+    }
+    QueryPipeline pipeline(search_server, pipeline_depth);
+    pipeline.Run(source, sink);
+}
+
+void ProcessQueriesStream(const SearchServer& search_server, istream& queries, const QueryResultSink& sink, size_t pipeline_depth)
+{
+    ProcessQueriesStream(search_server, [&queries](string& query) {
+        return static_cast<bool>(getline(queries, query));
+    }, sink, pipeline_depth);
+}
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "document.h"
+#include "query_executor.h"
 #include "search_server.h"
+#include <functional>
+#include <istream>
 #include <string>
 #include <vector>
 
@@ -9,3 +12,34 @@
 std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server, const std::vector<std::string>& queries);
 
 std::vector<Document>ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries);
+
+// То же на постоянном пуле потоков: каждый запрос - отдельная задача
+std::vector<std::vector<Document>> ProcessQueries(QueryExecutor& executor, const SearchServer& search_server, const std::vector<std::string>& queries);
+
+std::vector<Document> ProcessQueriesJoined(QueryExecutor& executor, const SearchServer& search_server, const std::vector<std::string>& queries);
+
+// Источник запросов: записывает очередной запрос в аргумент, false - запросы закончились
+using QuerySource = std::function<bool(std::string&)>;
+// Получатель результатов: номер запроса в потоке и найденные документы
+using QueryResultSink = std::function<void(size_t, const std::vector<Document>&)>;
+
+// Потоковая обработка: запросы выполняются параллельно, но в работе одновременно не больше
+// pipeline_depth запросов (0 - по числу потоков), поэтому память не зависит от размера пакета.
+// sink вызывается в вызывающем потоке строго в порядке запросов.
+// Исключение из FindTopDocuments, источника или sink прерывает обработку и пробрасывается.
+void ProcessQueriesStream(const SearchServer& search_server, const QuerySource& source, const QueryResultSink& sink, size_t pipeline_depth = 0);
+
+// Запросы читаются из потока по одному на строку
+void ProcessQueriesStream(const SearchServer& search_server, std::istream& queries, const QueryResultSink& sink, size_t pipeline_depth = 0);
+
+template <typename QueryIterator>
+void ProcessQueriesStream(const SearchServer& search_server, QueryIterator first, QueryIterator last, const QueryResultSink& sink, size_t pipeline_depth = 0)
+{
+    ProcessQueriesStream(search_server, [&first, last](std::string& query) {
+        if (first == last) {
+            return false;
+        }
+        query = *first++;
+        return true;
+    }, sink, pipeline_depth);
+}
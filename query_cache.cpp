@@ -0,0 +1,70 @@
+#include "query_cache.h"
+
+QueryCache::QueryCache(size_t capacity)
+    : capacity_(capacity)
+{
+}
+
+std::optional<std::vector<Document>> QueryCache::Find(const std::string& key, uint64_t generation)
+{
+    std::unique_lock guard(mutex_, std::try_to_lock);
+    if (!guard) {
+        ++contended_;
+        return std::nullopt;
+    }
+    SyncGeneration(generation);
+    const auto it = index_.find(key);
+    if (it == index_.end()) {
+        ++stats_.misses;
+        return std::nullopt;
+    }
+    ++stats_.hits;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->documents;
+}
+
+void QueryCache::Insert(const std::string& key, uint64_t generation, const std::vector<Document>& documents)
+{
+    if (capacity_ == 0) {
+        return;
+    }
+    std::unique_lock guard(mutex_, std::try_to_lock);
+    if (!guard) {
+        ++contended_;
+        return;
+    }
+    SyncGeneration(generation);
+    if (generation != generation_) {
+        return;
+    }
+    const auto it = index_.find(key);
+    if (it != index_.end()) {
+        it->second->documents = documents;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+    }
+    if (entries_.size() == capacity_) {
+        index_.erase(entries_.back().key);
+        entries_.pop_back();
+        ++stats_.evictions;
+    }
+    entries_.push_front({key, documents});
+    index_.emplace(key, entries_.begin());
+}
+
+QueryCacheStats QueryCache::GetStats() const
+{
+    std::lock_guard guard(mutex_);
+    QueryCacheStats stats = stats_;
+    stats.contended = contended_;
+    return stats;
+}
+
+void QueryCache::SyncGeneration(uint64_t generation)
+{
+    if (generation > generation_) {
+        entries_.clear();
+        index_.clear();
+        generation_ = generation;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+
+struct QueryCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    // Обращения, пропущенные из-за того, что кеш был занят другим потоком
+    uint64_t contended = 0;
+};
+
+// LRU-кеш результатов поиска. Ключ - нормализованный запрос, результат действителен
+// только для того поколения индекса, при котором был получен. Потокобезопасен и не блокирует
+// читателей: если кеш занят другим потоком, Find возвращает промах, а Insert ничего не делает,
+// поэтому поиск не ждёт других поисков из-за кеша.
+class QueryCache {
+public:
+    explicit QueryCache(size_t capacity);
+
+    std::optional<std::vector<Document>> Find(const std::string& key, uint64_t generation);
+
+    void Insert(const std::string& key, uint64_t generation, const std::vector<Document>& documents);
+
+    QueryCacheStats GetStats() const;
+
+    size_t GetCapacity() const
+    {
+        return capacity_;
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        std::vector<Document> documents;
+    };
+
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::atomic<uint64_t> contended_{0};
+    uint64_t generation_ = 0;
+    // В начале списка - недавно использованные
+    std::list<Entry> entries_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    QueryCacheStats stats_;
+
+    // Изменение индекса делает недействительным весь кеш
+    void SyncGeneration(uint64_t generation);
+};
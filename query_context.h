@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+#include "posting_list.h"
+#include "top_documents.h"
+
+class FrozenSegment;
+class SearchServer;
+
+// Рабочие буферы одного запроса. Передаётся в перегрузки SearchServer::FindTopDocuments
+// и MatchDocument и переиспользуется между запросами, поэтому в установившемся режиме
+// поиск не выделяет память. Результаты живут в контексте до следующего запроса.
+// Один контекст нельзя использовать из нескольких потоков одновременно.
+class QueryContext {
+public:
+    QueryContext() = default;
+
+    QueryContext(const QueryContext&) = delete;
+    QueryContext& operator=(const QueryContext&) = delete;
+
+private:
+    friend class FrozenSegment;
+    friend class SearchServer;
+
+    enum class DocumentState : uint8_t {
+        UNTOUCHED,
+        SCORED,
+        EXCLUDED,
+    };
+
+    std::vector<std::string_view> words_;
+    std::vector<std::string_view> plus_words_;
+    std::vector<std::string_view> minus_words_;
+    std::vector<std::string_view> matched_words_;
+
+    // Плотный накопитель по внутренним индексам документов; touched_ - что обнулять после запроса
+    std::vector<Relevance> scores_;
+    std::vector<DocumentState> states_;
+    std::vector<int> touched_;
+
+    TopDocumentsSelector selector_{0};
+
+    void Prepare(size_t document_slot_count)
+    {
+        if (scores_.size() < document_slot_count) {
+            scores_.resize(document_slot_count, 0.0);
+            states_.resize(document_slot_count, DocumentState::UNTOUCHED);
+        }
+    }
+
+    void Exclude(int document_index)
+    {
+        if (states_[document_index] == DocumentState::UNTOUCHED) {
+            touched_.push_back(document_index);
+        }
+        states_[document_index] = DocumentState::EXCLUDED;
+    }
+
+    bool IsExcluded(int document_index) const
+    {
+        return states_[document_index] == DocumentState::EXCLUDED;
+    }
+
+    // Отмечает документы, которым ядро подсчёта добавило релевантность в scores_
+    void MarkScored(const int* document_indices, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            if (states_[document_indices[i]] == DocumentState::UNTOUCHED) {
+                states_[document_indices[i]] = DocumentState::SCORED;
+                touched_.push_back(document_indices[i]);
+            }
+        }
+    }
+
+    template <typename Function>
+    void ForEachScored(Function function) const
+    {
+        for (const int document_index : touched_) {
+            if (states_[document_index] == DocumentState::SCORED) {
+                function(document_index, scores_[document_index]);
+            }
+        }
+    }
+
+    void Reset()
+    {
+        for (const int document_index : touched_) {
+            scores_[document_index] = 0.0;
+            states_[document_index] = DocumentState::UNTOUCHED;
+        }
+        touched_.clear();
+    }
+};
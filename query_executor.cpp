@@ -0,0 +1,191 @@
+#include "query_executor.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace {
+
+// Пул и номер, к которым относится текущий поток
+thread_local const QueryExecutor* current_executor = nullptr;
+thread_local size_t current_worker_index = 0;
+
+} // namespace
+
+struct QueryExecutor::Batch {
+    const std::function<void(size_t)>* function;
+    std::atomic<size_t> remaining;
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable done;
+    bool finished = false;
+};
+
+QueryExecutor::QueryExecutor(size_t worker_count)
+{
+    if (worker_count == 0) {
+        worker_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers_.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers_[i]->thread = std::thread([this, i] { Work(i); });
+    }
+}
+
+QueryExecutor::~QueryExecutor()
+{
+    {
+        std::lock_guard lock(wake_mutex_);
+        stopped_ = true;
+    }
+    wake_.notify_all();
+    for (const auto& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+void QueryExecutor::ParallelFor(size_t count, const std::function<void(size_t)>& function)
+{
+    if (count == 0) {
+        return;
+    }
+    Batch batch;
+    batch.function = &function;
+    batch.remaining = count;
+
+    // Счётчик увеличивается до публикации задач: иначе уже проснувшийся поток может взять
+    // задачу и уменьшить его раньше, и беззнаковый счётчик переполнится
+    {
+        std::lock_guard lock(wake_mutex_);
+        pending_ += count;
+    }
+
+    // Каждому потоку - непрерывный отрезок индексов, неравномерность выравнивается перехватом
+    const size_t worker_count = workers_.size();
+    for (size_t worker = 0; worker < worker_count; ++worker) {
+        const size_t first = count * worker / worker_count;
+        const size_t last = count * (worker + 1) / worker_count;
+        if (first == last) {
+            continue;
+        }
+        std::lock_guard lock(workers_[worker]->mutex);
+        for (size_t index = first; index < last; ++index) {
+            workers_[worker]->tasks.push_back({&batch, index});
+        }
+    }
+    wake_.notify_all();
+
+    // Поток пула не должен простаивать в ожидании, иначе вложенные вызовы займут весь пул
+    const size_t worker_index = GetCurrentWorkerIndex();
+    if (worker_index < worker_count) {
+        Task task;
+        while (batch.remaining > 0 && TryTake(worker_index, task)) {
+            Execute(worker_index, task);
+        }
+    }
+    {
+        std::unique_lock lock(batch.mutex);
+        batch.done.wait(lock, [&batch] { return batch.finished; });
+    }
+    if (batch.error) {
+        std::rethrow_exception(batch.error);
+    }
+}
+
+std::vector<QueryExecutorWorkerStats> QueryExecutor::GetWorkerStats() const
+{
+    std::vector<QueryExecutorWorkerStats> stats;
+    stats.reserve(workers_.size());
+    for (const auto& worker : workers_) {
+        stats.push_back({worker->executed_tasks, worker->stolen_tasks, std::chrono::nanoseconds(worker->busy_nanoseconds)});
+    }
+    return stats;
+}
+
+void QueryExecutor::ResetStats()
+{
+    for (const auto& worker : workers_) {
+        worker->executed_tasks = 0;
+        worker->stolen_tasks = 0;
+        worker->busy_nanoseconds = 0;
+    }
+}
+
+void QueryExecutor::Work(size_t worker_index)
+{
+    current_executor = this;
+    current_worker_index = worker_index;
+    Task task;
+    while (true) {
+        if (TryTake(worker_index, task)) {
+            Execute(worker_index, task);
+            continue;
+        }
+        std::unique_lock lock(wake_mutex_);
+        wake_.wait(lock, [this] { return stopped_ || pending_ > 0; });
+        if (stopped_ && pending_ == 0) {
+            return;
+        }
+    }
+}
+
+bool QueryExecutor::TryTake(size_t worker_index, Task& task)
+{
+    // Свои задачи - с начала очереди, чужие - с конца
+    {
+        Worker& worker = *workers_[worker_index];
+        std::lock_guard lock(worker.mutex);
+        if (!worker.tasks.empty()) {
+            task = worker.tasks.front();
+            worker.tasks.pop_front();
+            --pending_;
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset < workers_.size(); ++offset) {
+        Worker& victim = *workers_[(worker_index + offset) % workers_.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            --pending_;
+            ++workers_[worker_index]->stolen_tasks;
+            return true;
+        }
+    }
+    return false;
+}
+
+void QueryExecutor::Execute(size_t worker_index, const Task& task)
+{
+    Batch& batch = *task.batch;
+    if (!batch.failed) {
+        const auto start = std::chrono::steady_clock::now();
+        try {
+            (*batch.function)(task.index);
+        } catch (...) {
+            std::lock_guard lock(batch.mutex);
+            if (!batch.error) {
+                batch.error = std::current_exception();
+            }
+            batch.failed = true;
+        }
+        Worker& worker = *workers_[worker_index];
+        worker.busy_nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        ++worker.executed_tasks;
+    }
+    if (--batch.remaining == 0) {
+        // Уведомление под мьютексом: после него ожидающий поток может уничтожить batch
+        std::lock_guard lock(batch.mutex);
+        batch.finished = true;
+        batch.done.notify_all();
+    }
+}
+
+size_t QueryExecutor::GetCurrentWorkerIndex() const
+{
+    return current_executor == this ? current_worker_index : workers_.size();
+}
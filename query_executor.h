@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct QueryExecutorWorkerStats {
+    uint64_t executed_tasks = 0;
+    // Из них взято из очередей других потоков
+    uint64_t stolen_tasks = 0;
+    std::chrono::nanoseconds busy_time{0};
+};
+
+class QueryExecutor;
+
+// Передаётся вместо std::execution::par, чтобы выполнять поиск на пуле QueryExecutor
+struct ExecutorPolicy {
+    QueryExecutor* executor;
+};
+
+// Постоянный пул потоков с перехватом работы: у каждого потока своя очередь задач,
+// освободившийся поток забирает задачи из хвоста чужих очередей.
+// Потоки живут всё время жизни объекта и переиспользуются между пакетами запросов.
+class QueryExecutor {
+public:
+    // worker_count == 0 - по числу аппаратных потоков
+    explicit QueryExecutor(size_t worker_count = 0);
+
+    QueryExecutor(const QueryExecutor&) = delete;
+    QueryExecutor& operator=(const QueryExecutor&) = delete;
+
+    ~QueryExecutor();
+
+    size_t GetWorkerCount() const
+    {
+        return workers_.size();
+    }
+
+    ExecutorPolicy GetPolicy()
+    {
+        return {this};
+    }
+
+    // Вызывает function(i) для всех i из [0, count) на потоках пула и ждёт завершения.
+    // Можно вызывать из нескольких потоков и из задач самого пула: ожидающий поток пула
+    // в это время выполняет задачи. Первое исключение из function пробрасывается,
+    // оставшиеся задачи пакета пропускаются.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& function);
+
+    std::vector<QueryExecutorWorkerStats> GetWorkerStats() const;
+
+    void ResetStats();
+
+private:
+    struct Batch;
+
+    struct Task {
+        Batch* batch;
+        size_t index;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::atomic<uint64_t> executed_tasks{0};
+        std::atomic<uint64_t> stolen_tasks{0};
+        std::atomic<int64_t> busy_nanoseconds{0};
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    // Задачи, лежащие в очередях
+    std::atomic<size_t> pending_{0};
+    bool stopped_ = false;
+
+    void Work(size_t worker_index);
+
+    bool TryTake(size_t worker_index, Task& task);
+
+    void Execute(size_t worker_index, const Task& task);
+
+    // Номер текущего потока в пуле или GetWorkerCount(), если поток не из пула
+    size_t GetCurrentWorkerIndex() const;
+};
@@ -1,31 +1,246 @@
 #include "remove_duplicates.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <execution>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+namespace {
+
+// Отпечаток набора слов: хеш упорядоченной последовательности слов документа
+uint64_t ComputeFingerprint(const WordFrequenciesView& words)
+{
+    uint64_t fingerprint = words.size();
+    for (const auto& [word, freq] : words) {
+        fingerprint ^= std::hash<std::string_view>{}(word) + 0x9E3779B97F4A7C15ull + (fingerprint << 6) + (fingerprint >> 2);
+    }
+    return fingerprint;
+}
+
+bool HaveSameWords(const WordFrequenciesView& lhs, const WordFrequenciesView& rhs)
+{
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const auto& lhs_item, const auto& rhs_item) {
+        return lhs_item.first == rhs_item.first;
+    });
+}
+
+constexpr size_t MINHASH_SIZE = 128;
+
+// Сколько предыдущих документов корзины LSH сравнивается с очередным
+constexpr size_t MAX_BUCKET_NEIGHBOURS = 32;
+
+uint64_t MixHash(uint64_t value)
+{
+    // splitmix64
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+// MinHash: для каждой из MINHASH_SIZE хеш-функций - минимум по словам документа
+void ComputeMinHash(const WordFrequenciesView& words, uint64_t* signature)
+{
+    std::fill(signature, signature + MINHASH_SIZE, std::numeric_limits<uint64_t>::max());
+    for (const auto& [word, freq] : words) {
+        const uint64_t word_hash = std::hash<std::string_view>{}(word);
+        for (size_t i = 0; i < MINHASH_SIZE; ++i) {
+            signature[i] = std::min(signature[i], MixHash(word_hash ^ (i * 0xD6E8FEB86659FD93ull)));
+        }
+    }
+}
+
+// Число строк в полосе: наибольшее, при котором порог срабатывания LSH (1/b)^(1/r) не выше threshold.
+// Лишние кандидаты отсеиваются точной проверкой, а пропущенные пары уже не вернуть.
+size_t ChooseBandRows(double threshold)
+{
+    size_t best_rows = 1;
+    for (size_t rows = 2; rows <= MINHASH_SIZE; rows *= 2) {
+        const double band_threshold = std::pow(1.0 / static_cast<double>(MINHASH_SIZE / rows), 1.0 / static_cast<double>(rows));
+        if (band_threshold <= threshold) {
+            best_rows = rows;
+        }
+    }
+    return best_rows;
+}
+
+double ComputeJaccard(const WordFrequenciesView& lhs, const WordFrequenciesView& rhs)
+{
+    if (lhs.empty() && rhs.empty()) {
+        return 1.0;
+    }
+    size_t common = 0;
+    for (auto lhs_it = lhs.begin(), rhs_it = rhs.begin(); lhs_it != lhs.end() && rhs_it != rhs.end();) {
+        const std::string_view lhs_word = (*lhs_it).first;
+        const std::string_view rhs_word = (*rhs_it).first;
+        if (lhs_word < rhs_word) {
+            ++lhs_it;
+        } else if (rhs_word < lhs_word) {
+            ++rhs_it;
+        } else {
+            ++common;
+            ++lhs_it;
+            ++rhs_it;
+        }
+    }
+    return static_cast<double>(common) / static_cast<double>(lhs.size() + rhs.size() - common);
+}
+
+size_t FindRoot(std::vector<size_t>& parents, size_t index)
+{
+    while (parents[index] != index) {
+        parents[index] = parents[parents[index]];
+        index = parents[index];
+    }
+    return index;
+}
+
+} // namespace
+
+std::vector<int> FindDuplicates(const SearchServer& search_server)
+{
+    const std::vector<int> document_ids(search_server.begin(), search_server.end());
+    std::vector<uint64_t> fingerprints(document_ids.size());
+    std::transform(std::execution::par, document_ids.begin(), document_ids.end(), fingerprints.begin(), [&search_server](int document_id) {
+        return ComputeFingerprint(search_server.GetWordFrequencies(document_id));
+    });
+
+    // Документы с одинаковым отпечатком оказываются рядом, внутри группы - по возрастанию id
+    std::vector<size_t> order(document_ids.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(std::execution::par, order.begin(), order.end(), [&fingerprints](size_t lhs, size_t rhs) {
+        return fingerprints[lhs] != fingerprints[rhs] ? fingerprints[lhs] < fingerprints[rhs] : lhs < rhs;
+    });
+
+    // Слова сравниваются только внутри группы: при коллизии хеша в ней несколько разных наборов
+    std::vector<int> duplicates;
+    std::vector<size_t> group_originals;
+    for (auto group_begin = order.begin(); group_begin != order.end();) {
+        const auto group_end = std::find_if(group_begin, order.end(), [&fingerprints, group_begin](size_t index) {
+            return fingerprints[index] != fingerprints[*group_begin];
+        });
+        group_originals.clear();
+        for (auto it = group_begin; it != group_end; ++it) {
+            const auto& words = search_server.GetWordFrequencies(document_ids[*it]);
+            const bool is_duplicate = std::any_of(group_originals.begin(), group_originals.end(), [&](size_t original) {
+                return HaveSameWords(search_server.GetWordFrequencies(document_ids[original]), words);
+            });
+            if (is_duplicate) {
+                duplicates.push_back(document_ids[*it]);
+            } else {
+                group_originals.push_back(*it);
+            }
+        }
+        group_begin = group_end;
+    }
+    std::sort(duplicates.begin(), duplicates.end());
+    return duplicates;
+}
 
 void RemoveDuplicates(SearchServer& search_server)
 {
-    std::vector<int> delete_documents;
-    std::set<std::set<std::string>> words_in_docs;
-    for (const int &document_id : search_server) {
-          const auto &words = search_server.GetWordFrequencies(document_id);
-          std::set<std::string> words_one_doc;
-
-          for(const auto& [word, freak] : words)
-          {
-              words_one_doc.insert(word);
-          }
-
-          if(words_in_docs.count(words_one_doc) > 0)
-          {
-              delete_documents.push_back(document_id);
-          }
-          else
-          {
-              words_in_docs.insert(words_one_doc);
-          }
-    }
-    for( int del: delete_documents )
-    {
-        std::cout << "Found duplicate document id " << del << std::endl;
-        search_server.RemoveDocument(del);
+    for (const int document_id : FindDuplicates(search_server)) {
+        std::cout << "Found duplicate document id " << document_id << std::endl;
+        search_server.RemoveDocument(document_id);
+    }
+}
+
+std::vector<std::vector<int>> FindNearDuplicates(const SearchServer& search_server, double threshold)
+{
+    const std::vector<int> document_ids(search_server.begin(), search_server.end());
+    const size_t document_count = document_ids.size();
+    std::vector<uint64_t> signatures(document_count * MINHASH_SIZE);
+    std::vector<size_t> indices(document_count);
+    std::iota(indices.begin(), indices.end(), 0);
+    std::for_each(std::execution::par, indices.begin(), indices.end(), [&](size_t index) {
+        ComputeMinHash(search_server.GetWordFrequencies(document_ids[index]), &signatures[index * MINHASH_SIZE]);
+    });
+
+    // В каждой полосе документы с одинаковым хешем строк полосы - кандидаты.
+    // В корзине каждый документ сравнивается с MAX_BUCKET_NEIGHBOURS предыдущими и с первым:
+    // корзины обычно малы и проверяются полностью, а большие не дают квадратичного перебора.
+    const size_t rows = ChooseBandRows(threshold);
+    std::vector<size_t> bands(MINHASH_SIZE / rows);
+    std::iota(bands.begin(), bands.end(), 0);
+    std::vector<std::vector<std::pair<size_t, size_t>>> band_candidates(bands.size());
+    std::for_each(std::execution::par, bands.begin(), bands.end(), [&](size_t band) {
+        std::vector<std::pair<uint64_t, size_t>> buckets(document_count);
+        for (size_t index = 0; index < document_count; ++index) {
+            uint64_t band_hash = band;
+            for (size_t row = band * rows; row < (band + 1) * rows; ++row) {
+                band_hash = MixHash(band_hash ^ signatures[index * MINHASH_SIZE + row]);
+            }
+            buckets[index] = {band_hash, index};
+        }
+        std::sort(buckets.begin(), buckets.end());
+        auto& candidates = band_candidates[band];
+        for (size_t i = 1, first = 0; i < buckets.size(); ++i) {
+            if (buckets[i].first != buckets[i - 1].first) {
+                first = i;
+                continue;
+            }
+            const size_t nearest = i - first > MAX_BUCKET_NEIGHBOURS ? i - MAX_BUCKET_NEIGHBOURS : first;
+            if (nearest != first) {
+                candidates.push_back({buckets[first].second, buckets[i].second});
+            }
+            for (size_t j = nearest; j < i; ++j) {
+                candidates.push_back({buckets[j].second, buckets[i].second});
+            }
+        }
+    });
+    std::vector<std::pair<size_t, size_t>> candidates;
+    for (const auto& band : band_candidates) {
+        candidates.insert(candidates.end(), band.begin(), band.end());
+    }
+    std::sort(std::execution::par, candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    // Точная проверка кандидатов
+    std::vector<char> is_similar(candidates.size());
+    std::transform(std::execution::par, candidates.begin(), candidates.end(), is_similar.begin(), [&](const auto& candidate) {
+        return ComputeJaccard(search_server.GetWordFrequencies(document_ids[candidate.first]),
+            search_server.GetWordFrequencies(document_ids[candidate.second])) >= threshold;
+    });
+
+    std::vector<size_t> parents(document_count);
+    std::iota(parents.begin(), parents.end(), 0);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (is_similar[i]) {
+            const size_t lhs_root = FindRoot(parents, candidates[i].first);
+            const size_t rhs_root = FindRoot(parents, candidates[i].second);
+            // Корень - документ с меньшим индексом, то есть с меньшим id
+            parents[std::max(lhs_root, rhs_root)] = std::min(lhs_root, rhs_root);
+        }
+    }
+
+    std::vector<std::vector<int>> clusters;
+    std::vector<size_t> cluster_of_root(document_count, std::numeric_limits<size_t>::max());
+    for (size_t index = 0; index < document_count; ++index) {
+        const size_t root = FindRoot(parents, index);
+        if (root == index) {
+            continue;
+        }
+        if (cluster_of_root[root] == std::numeric_limits<size_t>::max()) {
+            cluster_of_root[root] = clusters.size();
+            clusters.push_back({document_ids[root]});
+        }
+        clusters[cluster_of_root[root]].push_back(document_ids[index]);
+    }
+    std::sort(clusters.begin(), clusters.end());
+    return clusters;
+}
+
+void RemoveNearDuplicates(SearchServer& search_server, double threshold)
+{
+    for (const auto& cluster : FindNearDuplicates(search_server, threshold)) {
+        for (auto it = cluster.begin() + 1; it != cluster.end(); ++it) {
+            std::cout << "Found near duplicate document id " << *it << " of " << cluster.front() << std::endl;
+            search_server.RemoveDocument(*it);
+        }
     }
 }
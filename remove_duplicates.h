@@ -1,5 +1,22 @@
 #pragma once
 #include "search_server.h"
 
+#include <vector>
+
+// Id документов, набор слов которых совпадает с набором слов документа с меньшим id (по возрастанию)
+std::vector<int> FindDuplicates(const SearchServer& search_server);
+
 void RemoveDuplicates(SearchServer& search_server);
 
+// Кластеры почти одинаковых документов: в кластер попадают документы, у которых
+// коэффициент Жаккара наборов слов не меньше threshold (связь транзитивна).
+// Кандидаты ищутся по MinHash-сигнатурам с LSH-разбиением на полосы, поэтому время почти линейно
+// по числу документов; каждый кандидат проверяется точно. Внутри кластера id по возрастанию,
+// кластеры упорядочены по первому id.
+// Поиск приближённый: лишних пар не бывает, но пара может не стать кандидатом. При threshold 0.8
+// (16 полос по 8 строк) пара с коэффициентом J находится с вероятностью 1 - (1 - J^8)^16:
+// около 95% при J = 0.8, 99.9% при 0.875, 99.99% при 0.9.
+std::vector<std::vector<int>> FindNearDuplicates(const SearchServer& search_server, double threshold = 0.8);
+
+// Удаляет из каждого кластера FindNearDuplicates все документы, кроме документа с наименьшим id
+void RemoveNearDuplicates(SearchServer& search_server, double threshold = 0.8);
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+
+// Таблица "id документа -> релевантность" с открытой адресацией и линейным пробированием.
+// Рассчитана на один поток: при параллельном поиске у каждого потока своя таблица,
+// а в конце таблицы сливаются через Merge.
+class ScoreTable {
+public:
+    static constexpr int EMPTY_KEY = -1;
+
+    struct Entry {
+        int key = EMPTY_KEY;
+        Relevance value = 0.0;
+    };
+
+    explicit ScoreTable(size_t expected_size = 0)
+    {
+        size_t capacity = MIN_CAPACITY;
+        while (capacity < expected_size * 2) {
+            capacity *= 2;
+        }
+        entries_.resize(capacity);
+    }
+
+    Relevance& operator[](int key)
+    {
+        size_t pos = FindSlot(key);
+        if (entries_[pos].key == EMPTY_KEY) {
+            if ((size_ + 1) * 2 > entries_.size()) {
+                Rehash(entries_.size() * 2);
+                pos = FindSlot(key);
+            }
+            entries_[pos].key = key;
+            ++size_;
+        }
+        return entries_[pos].value;
+    }
+
+    void Erase(int key)
+    {
+        size_t pos = FindSlot(key);
+        if (entries_[pos].key == EMPTY_KEY) {
+            return;
+        }
+        // Обратный сдвиг: переносим следующие элементы цепочки на место удалённого
+        const size_t mask = entries_.size() - 1;
+        size_t next = pos;
+        while (true) {
+            next = (next + 1) & mask;
+            if (entries_[next].key == EMPTY_KEY) {
+                break;
+            }
+            const size_t home = Hash(entries_[next].key) & mask;
+            if (((next - home) & mask) >= ((next - pos) & mask)) {
+                entries_[pos] = entries_[next];
+                pos = next;
+            }
+        }
+        entries_[pos] = Entry{};
+        --size_;
+    }
+
+    void Merge(const ScoreTable& other)
+    {
+        for (const Entry& entry : other.entries_) {
+            if (entry.key != EMPTY_KEY) {
+                (*this)[entry.key] += entry.value;
+            }
+        }
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    template <typename Function>
+    void ForEach(Function function) const
+    {
+        for (const Entry& entry : entries_) {
+            if (entry.key != EMPTY_KEY) {
+                function(entry.key, entry.value);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    std::vector<Entry> entries_;
+    size_t size_ = 0;
+
+    static size_t Hash(int key)
+    {
+        // Мультипликативное хеширование Фибоначчи
+        return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(key)) * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    size_t FindSlot(int key) const
+    {
+        const size_t mask = entries_.size() - 1;
+        size_t pos = Hash(key) & mask;
+        while (entries_[pos].key != EMPTY_KEY && entries_[pos].key != key) {
+            pos = (pos + 1) & mask;
+        }
+        return pos;
+    }
+
+    void Rehash(size_t capacity)
+    {
+        std::vector<Entry> old_entries(capacity);
+        std::swap(entries_, old_entries);
+        for (const Entry& entry : old_entries) {
+            if (entry.key != EMPTY_KEY) {
+                entries_[FindSlot(entry.key)] = entry;
+            }
+        }
+    }
+};
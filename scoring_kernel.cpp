@@ -0,0 +1,95 @@
+#include "scoring_kernel.h"
+
+#include <type_traits>
+
+// Умножение и сложение не сливаются в FMA: результат всех реализаций совпадает со скалярным побитово
+#pragma GCC optimize("fp-contract=off")
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+void AccumulateScoresScalar(const int* document_ids, const Relevance* term_freqs, size_t count, Relevance inverse_document_freq, Relevance* scores) {
+    for (size_t i = 0; i < count; ++i) {
+        scores[document_ids[i]] += term_freqs[i] * inverse_document_freq;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#ifdef SEARCH_SERVER_FLOAT_RELEVANCE
+// В AVX2 есть сбор по индексам, но нет записи: суммы раскладываются по документам поэлементно.
+// Для double (4 элемента за сбор) это медленнее скалярного цикла, поэтому вариант только для float.
+__attribute__((target("avx2")))
+void AccumulateScoresAvx2(const int* document_ids, const float* term_freqs, size_t count, float inverse_document_freq, float* scores) {
+    const __m256 idf = _mm256_set1_ps(inverse_document_freq);
+    alignas(32) float sums[8];
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i indices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(document_ids + i));
+        const __m256 products = _mm256_mul_ps(_mm256_loadu_ps(term_freqs + i), idf);
+        const __m256 old_scores = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), scores, indices, _mm256_castsi256_ps(_mm256_set1_epi32(-1)), 4);
+        _mm256_store_ps(sums, _mm256_add_ps(old_scores, products));
+        for (size_t lane = 0; lane < 8; ++lane) {
+            scores[document_ids[i + lane]] = sums[lane];
+        }
+    }
+    AccumulateScoresScalar(document_ids + i, term_freqs + i, count - i, inverse_document_freq, scores);
+}
+#endif
+
+// Шаблон по типу релевантности: инструкции для double и float различаются
+template <typename T>
+__attribute__((target("avx512f")))
+void AccumulateScoresAvx512(const int* document_ids, const T* term_freqs, size_t count, T inverse_document_freq, T* scores) {
+    size_t i = 0;
+    if constexpr (std::is_same_v<T, double>) {
+        const __m512d idf = _mm512_set1_pd(inverse_document_freq);
+        for (; i + 8 <= count; i += 8) {
+            const __m256i indices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(document_ids + i));
+            const __m512d products = _mm512_mul_pd(_mm512_loadu_pd(term_freqs + i), idf);
+            const __m512d old_scores = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, indices, scores, 8);
+            _mm512_i32scatter_pd(scores, indices, _mm512_add_pd(old_scores, products), 8);
+        }
+    } else {
+        const __m512 idf = _mm512_set1_ps(inverse_document_freq);
+        for (; i + 16 <= count; i += 16) {
+            const __m512i indices = _mm512_loadu_si512(document_ids + i);
+            const __m512 products = _mm512_mul_ps(_mm512_loadu_ps(term_freqs + i), idf);
+            const __m512 old_scores = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, indices, scores, 4);
+            _mm512_i32scatter_ps(scores, indices, _mm512_add_ps(old_scores, products), 4);
+        }
+    }
+    AccumulateScoresScalar(document_ids + i, term_freqs + i, count - i, inverse_document_freq, scores);
+}
+
+#endif
+
+using AccumulateFunction = void (*)(const int*, const Relevance*, size_t, Relevance, Relevance*);
+
+AccumulateFunction GetAccumulateFunction(SimdLevel level) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (level >= SimdLevel::AVX512 && IsSimdLevelSupported(SimdLevel::AVX512)) {
+        return AccumulateScoresAvx512<Relevance>;
+    }
+#ifdef SEARCH_SERVER_FLOAT_RELEVANCE
+    if (level >= SimdLevel::AVX2 && IsSimdLevelSupported(SimdLevel::AVX2)) {
+        return AccumulateScoresAvx2;
+    }
+#endif
+#endif
+    return AccumulateScoresScalar;
+}
+
+} // namespace
+
+void AccumulateScores(const int* document_ids, const Relevance* term_freqs, size_t count, Relevance inverse_document_freq, Relevance* scores) {
+    static const AccumulateFunction accumulate = GetAccumulateFunction(GetBestSimdLevel());
+    accumulate(document_ids, term_freqs, count, inverse_document_freq, scores);
+}
+
+void AccumulateScores(SimdLevel level, const int* document_ids, const Relevance* term_freqs, size_t count, Relevance inverse_document_freq, Relevance* scores) {
+    GetAccumulateFunction(level)(document_ids, term_freqs, count, inverse_document_freq, scores);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+#include "cpu_features.h"
+#include "document.h"
+
+// Размер блока вхождений, которым поиск подаёт список в ядро подсчёта
+constexpr size_t SCORING_BLOCK_SIZE = 256;
+
+// Ядро подсчёта релевантности по блоку вхождений одного слова:
+// scores[document_ids[i]] += term_freqs[i] * inverse_document_freq для i < count.
+// id в блоке должны быть различны (список вхождений строго возрастает), поэтому векторная
+// запись по индексам не конфликтует. Умножение и сложение выполняются раздельно, без FMA,
+// поэтому все реализации дают побитово тот же результат, что и скалярная.
+void AccumulateScores(const int* document_ids, const Relevance* term_freqs, size_t count, Relevance inverse_document_freq, Relevance* scores);
+
+// Реализация заданного уровня (или лучшего доступного не выше него) - для тестов и замеров
+void AccumulateScores(SimdLevel level, const int* document_ids, const Relevance* term_freqs, size_t count, Relevance inverse_document_freq, Relevance* scores);
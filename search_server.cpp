@@ -1,49 +1,182 @@
 #include "search_server.h"
+#include <iterator>
 #include <set>
 
+SearchServer::SearchServer(const SearchServer& other)
+    : stop_words_(other.stop_words_)
+    , terms_(other.terms_)
+    , word_to_document_freqs_(other.word_to_document_freqs_)
+    , word_log_document_freqs_(other.word_log_document_freqs_)
+    , log_document_count_(other.log_document_count_)
+    , index_generation_(other.index_generation_)
+    , query_cache_(other.query_cache_ ? std::make_unique<QueryCache>(other.query_cache_->GetCapacity()) : nullptr)
+    , document_ids_(other.document_ids_)
+    , document_indices_(other.document_indices_)
+    , document_external_ids_(other.document_external_ids_)
+    , document_ratings_(other.document_ratings_)
+    , document_statuses_(other.document_statuses_)
+    , document_word_counts_(other.document_word_counts_)
+    , forward_index_(other.forward_index_)
+    , document_removed_(other.document_removed_)
+    , removed_slot_count_(other.removed_slot_count_)
+    , pending_removed_count_(other.pending_removed_count_)
+    , removal_deferred_(other.removal_deferred_)
+    , compaction_threshold_(other.compaction_threshold_)
+{
+}
+
 void SearchServer::AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
-    if ((document_id < 0) || (documents_.count(document_id) > 0)) {
+    if ((document_id < 0) || (document_indices_.count(document_id) > 0)) {
         throw std::invalid_argument("Invalid document_id");
     }
+    InsertDocument(document_id, status, ComputeAverageRating(ratings), ComputeWordFrequencies(document));
+}
+
+SearchServer::DocumentWords SearchServer::ComputeWordFrequencies(std::string_view document) const
+{
     std::vector<std::string_view> words = SplitIntoWordsNoStop(document);
     const double inv_word_count = 1.0 / words.size();
-    for (std::string_view& word : words) {
-        std::string s_word (word);
-        if (words_in_docs_.count(s_word) == 0) {
-            words_in_docs_[s_word].first = s_word;
-            std::string_view sv_word{ words_in_docs_.at(s_word).first };
-            words_in_docs_.at(s_word).second = sv_word;
+    std::sort(words.begin(), words.end());
+    DocumentWords result;
+    result.word_count = static_cast<int>(words.size());
+    for (auto it = words.begin(); it != words.end();) {
+        const auto next = std::find_if(it, words.end(), [word = *it](std::string_view other) { return other != word; });
+        result.word_freqs.push_back({*it, static_cast<Relevance>((next - it) * inv_word_count)});
+        it = next;
+    }
+    return result;
+}
+
+void SearchServer::InsertDocument(int document_id, DocumentStatus status, int rating, const DocumentWords& words)
+{
+    const int document_index = static_cast<int>(document_external_ids_.size());
+    forward_index_.AddDocument();
+    for (const auto& [word, term_freq] : words.word_freqs) {
+        const int term_id = terms_.Intern(word);
+        if (term_id == static_cast<int>(word_to_document_freqs_.size())) {
+            word_to_document_freqs_.emplace_back();
+            word_log_document_freqs_.emplace_back();
         }
-        word_to_document_freqs_[words_in_docs_.at(s_word).second][document_id] += inv_word_count;
-        document_and_word[document_id][words_in_docs_.at(s_word).second] += inv_word_count;
+        word_to_document_freqs_[term_id].Add(document_index, term_freq);
+        UpdateWordDocumentFreq(term_id);
+        // Слова приходят отсортированными
+        forward_index_.AddTerm(term_id, term_freq);
     }
-    documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status });
+    document_indices_.emplace(document_id, document_index);
+    document_external_ids_.push_back(document_id);
+    document_ratings_.push_back(rating);
+    document_statuses_.push_back(status);
+    document_word_counts_.push_back(words.word_count);
+    document_removed_.push_back(false);
     document_ids_.insert(document_id);
+    UpdateDocumentCount();
+    ++index_generation_;
+}
+
+void SearchServer::UpdateWordDocumentFreq(int term_id)
+{
+    const size_t document_freq = word_to_document_freqs_[term_id].size();
+    word_log_document_freqs_[term_id] = document_freq == 0 ? 0.0 : std::log(static_cast<double>(document_freq));
+}
+
+void SearchServer::UpdateDocumentCount()
+{
+    log_document_count_ = std::log(static_cast<double>(document_ids_.size() + pending_removed_count_));
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(std::execution::seq, raw_query, [status](int document_id, DocumentStatus statusp, int rating) { return statusp == status; });
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status, size_t max_result_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, status, max_result_count);
+}
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, std::string_view raw_query, DocumentStatus status, size_t max_result_count) const {
+    return FindTopDocuments(context, raw_query, [status](int, DocumentStatus document_status, int) { return document_status == status; }, max_result_count);
 }
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query) const {
     return FindTopDocuments(std::execution::seq, raw_query, DocumentStatus::ACTUAL);
 }
 
+void SearchServer::CollectStatistics(std::string_view raw_query, CorpusStatistics& statistics) const
+{
+    auto query = ParseQuery(raw_query);
+    NormalizeQuery(query);
+    statistics.document_count += GetDocumentCount() + static_cast<int>(pending_removed_count_);
+    for (const auto word : query.plus_words) {
+        const PostingList* postings = FindPostings(word);
+        statistics.document_freqs[word] += postings == nullptr ? 0 : static_cast<int>(postings->size());
+    }
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(QueryMode mode, std::string_view raw_query, DocumentStatus status, size_t max_result_count) const {
+    if (mode == QueryMode::ANY) {
+        return FindTopDocuments(raw_query, status, max_result_count);
+    }
+    const auto predicate = [status](int, DocumentStatus document_status, int) { return document_status == status; };
+    auto query = ParseQuery(raw_query);
+    NormalizeQuery(query);
+    if (!query_cache_) {
+        return FindTopDocuments(mode, query, predicate, max_result_count);
+    }
+    const std::string key = MakeQueryCacheKey(query, mode, status, max_result_count);
+    const uint64_t generation = index_generation_;
+    if (auto cached = query_cache_->Find(key, generation)) {
+        return std::move(*cached);
+    }
+    auto result = FindTopDocuments(mode, query, predicate, max_result_count);
+    query_cache_->Insert(key, generation, result);
+    return result;
+}
+
 int SearchServer::GetDocumentCount() const {
-    return documents_.size();
+    return document_ids_.size();
+}
+
+size_t SearchServer::MemoryUsage() const {
+    size_t result = sizeof(*this) + terms_.MemoryUsage() + forward_index_.MemoryUsage()
+        + word_to_document_freqs_.capacity() * sizeof(PostingList)
+        + word_log_document_freqs_.capacity() * sizeof(double)
+        + document_external_ids_.capacity() * sizeof(int)
+        + document_ratings_.capacity() * sizeof(int)
+        + document_statuses_.capacity() * sizeof(DocumentStatus)
+        + document_word_counts_.capacity() * sizeof(int)
+        + document_removed_.capacity() / 8;
+    for (const PostingList& postings : word_to_document_freqs_) {
+        result += postings.MemoryUsage() - sizeof(PostingList);
+    }
+    return result;
+}
+
+void SearchServer::EnableQueryCache(size_t capacity)
+{
+    query_cache_ = capacity == 0 ? nullptr : std::make_unique<QueryCache>(capacity);
+}
+
+QueryCacheStats SearchServer::GetQueryCacheStats() const
+{
+    return query_cache_ ? query_cache_->GetStats() : QueryCacheStats{};
+}
+
+int SearchServer::FindDocumentIndex(int document_id) const
+{
+    const auto it = document_indices_.find(document_id);
+    return it == document_indices_.end() ? -1 : it->second;
+}
+
+const PostingList* SearchServer::FindPostings(std::string_view word) const
+{
+    const int term_id = terms_.Find(word);
+    return term_id < 0 ? nullptr : &word_to_document_freqs_[term_id];
 }
 
 
 
-const std::map< std::string_view, double> &SearchServer::GetWordFrequencies(int document_id) const
+WordFrequenciesView SearchServer::GetWordFrequencies(int document_id) const
 {
-    static const std::map<std::string_view, double> empty_map;
-    auto it = document_and_word.find(document_id);
+    const int document_index = FindDocumentIndex(document_id);
 
-    if(it != document_and_word.end())
+    if(document_index >= 0)
     {
-        return it->second;
+        return forward_index_.GetWordFrequencies(document_index, terms_);
     }
-    return empty_map ;
+    return {};
 }
 
 std::tuple<std::vector< std::string_view>, DocumentStatus> SearchServer::MatchDocument( std::string_view raw_query, int document_id) const
@@ -54,7 +187,8 @@ std::tuple<std::vector< std::string_view>, DocumentStatus> SearchServer::MatchDo
 std::tuple<std::vector< std::string_view>, DocumentStatus>  SearchServer::MatchDocument
 (const std::execution::parallel_policy &,  std::string_view raw_query, int document_id) const
 {
-    if (document_ids_.count(document_id) == 0)
+    const int document_index = FindDocumentIndex(document_id);
+    if (document_index < 0)
     {
         throw  std::out_of_range("document_id is invalid");
     }
@@ -62,14 +196,15 @@ std::tuple<std::vector< std::string_view>, DocumentStatus>  SearchServer::MatchD
 
     std::vector<std::string_view> matched_words;
 
-    auto comp = [this, document_id](const auto val)
+    auto comp = [this, document_index](const auto val)
     {
-        return word_to_document_freqs_.find(val) != word_to_document_freqs_.end() and word_to_document_freqs_.at(val).count(document_id) ;
+        const PostingList* postings = FindPostings(val);
+        return postings != nullptr and postings->Contains(document_index) ;
     };
 
     if(std::any_of(query.minus_words.begin(), query.minus_words.end(),comp))
     {
-      return {matched_words, documents_.at(document_id).status};
+      return {matched_words, document_statuses_[document_index]};
     }
    matched_words.resize(query.plus_words.size());
    std::copy_if(query.plus_words.begin(),query.plus_words.end(),matched_words.begin(),comp);
@@ -78,14 +213,15 @@ std::tuple<std::vector< std::string_view>, DocumentStatus>  SearchServer::MatchD
    auto f = std::unique(matched_words.begin(),matched_words.end());
    matched_words.erase(f, matched_words.end());
 
-   return {matched_words,documents_.at(document_id).status };
+   return {matched_words, document_statuses_[document_index]};
 
 }
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument
 (const std::execution::sequenced_policy &,  std::string_view raw_query, int document_id) const
 {
-    if (document_ids_.count(document_id) == 0)
+    const int document_index = FindDocumentIndex(document_id);
+    if (document_index < 0)
     {
         throw  std::out_of_range("document_id is invalid");
     }
@@ -95,19 +231,15 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
     std::vector< std::string_view> matched_words;
 
     for (const  auto& word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
+        const PostingList* postings = FindPostings(word);
+        if (postings != nullptr && postings->Contains(document_index)) {
             matched_words.push_back(word);
         }
     }
 
     for (const  auto& word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
+        const PostingList* postings = FindPostings(word);
+        if (postings != nullptr && postings->Contains(document_index)) {
             matched_words.clear();
             break;
         }
@@ -118,11 +250,32 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
     matched_words.erase(f, matched_words.end());
 
 
-    return {matched_words, documents_.at(document_id).status};
+    return {matched_words, document_statuses_[document_index]};
 }
 
 
 
+std::tuple<const std::vector<std::string_view>&, DocumentStatus> SearchServer::MatchDocument(QueryContext& context, std::string_view raw_query, int document_id) const
+{
+    const int document_index = FindDocumentIndex(document_id);
+    if (document_index < 0)
+    {
+        throw  std::out_of_range("document_id is invalid");
+    }
+
+    ParseQuery(raw_query, context);
+    context.matched_words_.clear();
+
+    const auto contains = [this, document_index](std::string_view word) {
+        const PostingList* postings = FindPostings(word);
+        return postings != nullptr && postings->Contains(document_index);
+    };
+    if (std::none_of(context.minus_words_.begin(), context.minus_words_.end(), contains)) {
+        std::copy_if(context.plus_words_.begin(), context.plus_words_.end(), std::back_inserter(context.matched_words_), contains);
+    }
+    return {context.matched_words_, document_statuses_[document_index]};
+}
+
 void SearchServer::RemoveDocument(int document_id)
 {
 
@@ -132,50 +285,141 @@ void SearchServer::RemoveDocument(int document_id)
 
 void SearchServer::RemoveDocument(const __pstl::execution::sequenced_policy &, int document_id)
 {
-    if (document_ids_.count(document_id) == 1) {
-        for (auto [word, freq] : GetWordFrequencies(document_id)) {
-            word_to_document_freqs_[word].erase(document_id);
-            if (word_to_document_freqs_.count(word) == 1 && word_to_document_freqs_.at(word).size() == 0) {
-               std::string s_word{ word };
-                words_in_docs_.erase(s_word);
-            }
-        }
-        document_ids_.erase(document_id);
-        documents_.erase(document_id);
-        document_and_word.erase(document_id);
+    const int document_index = FindDocumentIndex(document_id);
+    if (document_index < 0) {
+        return;
     }
-    return;
-
+    if (removal_deferred_) {
+        RemoveDocumentData(document_id, document_index);
+        return;
+    }
+    // Термины остаются в словаре и после удаления последнего документа с ними
+    const auto [first_term_id, last_term_id] = forward_index_.GetTermIds(document_index);
+    for (auto it = first_term_id; it != last_term_id; ++it) {
+        const int term_id = *it;
+        word_to_document_freqs_[term_id].Erase(document_index);
+        UpdateWordDocumentFreq(term_id);
+    }
+    RemoveDocumentData(document_id, document_index);
 }
 
 void SearchServer::RemoveDocument(const __pstl::execution::parallel_policy &, int document_id)
 {
     using namespace std;
-    if (document_and_word.count(document_id) == 0) {
+    const int document_index = FindDocumentIndex(document_id);
+    if (document_index < 0) {
             return;
         }
+    if (removal_deferred_) {
+        RemoveDocumentData(document_id, document_index);
+        return;
+    }
 
-
-        const auto& word_freqs = document_and_word.at(document_id);
-        vector<string_view> words(word_freqs.size());
-        transform(
-            execution::par,
-            word_freqs.begin(), word_freqs.end(),
-            words.begin(),
-            [](const auto& item) { return item.first; }
-        );
+        const auto [first_term_id, last_term_id] = forward_index_.GetTermIds(document_index);
         for_each(
             execution::par,
-            words.begin(), words.end(),
-            [this, document_id](string_view word) {
-                word_to_document_freqs_.at(word).erase(document_id);
+            first_term_id, last_term_id,
+            [this, document_index](int term_id) {
+                word_to_document_freqs_[term_id].Erase(document_index);
+                UpdateWordDocumentFreq(term_id);
             });
 
 
-        document_ids_.erase(document_id);
-        documents_.erase(document_id);
-        document_and_word.erase(document_id);
+        RemoveDocumentData(document_id, document_index);
+
+}
+
+void SearchServer::RemoveDocumentData(int document_id, int document_index)
+{
+    document_ids_.erase(document_id);
+    document_indices_.erase(document_id);
+    forward_index_.ClearDocument(document_index);
+    document_removed_[document_index] = true;
+    ++removed_slot_count_;
+    if (removal_deferred_) {
+        ++pending_removed_count_;
+    }
+    UpdateDocumentCount();
+    ++index_generation_;
+    if (removal_deferred_) {
+        if (compaction_threshold_ > 0 && pending_removed_count_ > compaction_threshold_ * (document_ids_.size() + pending_removed_count_)) {
+            Compact();
+        }
+    } else if (removed_slot_count_ * 2 > document_removed_.size()) {
+        // Сжатие после удаления не меньше половины мест: в среднем O(1) на удаление
+        Compact();
+    }
+}
 
+void SearchServer::SetDeferredRemoval(bool enabled, double compaction_threshold)
+{
+    removal_deferred_ = enabled;
+    compaction_threshold_ = compaction_threshold;
+    if (!enabled && pending_removed_count_ > 0) {
+        Compact();
+    }
+}
+
+void SearchServer::Compact()
+{
+    // Новые индексы живых документов идут подряд в прежнем порядке
+    std::vector<int> new_indices(document_external_ids_.size(), -1);
+    int document_count = 0;
+    for (size_t index = 0; index < document_external_ids_.size(); ++index) {
+        if (!document_removed_[index]) {
+            new_indices[index] = document_count++;
+        }
+    }
+    std::for_each(std::execution::par, word_to_document_freqs_.begin(), word_to_document_freqs_.end(), [&new_indices](PostingList& postings) {
+        postings.RemapDocuments(new_indices);
+    });
+
+    // Слова без вхождений удаляются из словаря; остальные получают новые id в прежнем порядке,
+    // прямой индекс переводится на новые id
+    const bool has_unused_terms = std::any_of(word_to_document_freqs_.begin(), word_to_document_freqs_.end(), [](const PostingList& postings) {
+        return postings.empty();
+    });
+    if (has_unused_terms) {
+        TermDictionary terms;
+        std::vector<PostingList> word_to_document_freqs;
+        std::vector<int> new_term_ids(word_to_document_freqs_.size(), -1);
+        for (int term_id = 0; term_id < static_cast<int>(word_to_document_freqs_.size()); ++term_id) {
+            if (!word_to_document_freqs_[term_id].empty()) {
+                new_term_ids[term_id] = terms.Intern(terms_.GetTerm(term_id));
+                word_to_document_freqs.push_back(std::move(word_to_document_freqs_[term_id]));
+            }
+        }
+        forward_index_.RemapTerms(new_term_ids);
+        terms_ = std::move(terms);
+        word_to_document_freqs_ = std::move(word_to_document_freqs);
+        word_log_document_freqs_.resize(word_to_document_freqs_.size());
+    }
+
+    for (size_t index = 0; index < new_indices.size(); ++index) {
+        const int new_index = new_indices[index];
+        if (new_index < 0) {
+            continue;
+        }
+        document_external_ids_[new_index] = document_external_ids_[index];
+        document_ratings_[new_index] = document_ratings_[index];
+        document_statuses_[new_index] = document_statuses_[index];
+        document_word_counts_[new_index] = document_word_counts_[index];
+        document_indices_[document_external_ids_[new_index]] = new_index;
+    }
+    document_external_ids_.resize(document_count);
+    document_ratings_.resize(document_count);
+    document_statuses_.resize(document_count);
+    document_word_counts_.resize(document_count);
+    forward_index_.RemapDocuments(new_indices);
+    document_removed_.assign(document_count, false);
+    removed_slot_count_ = 0;
+    pending_removed_count_ = 0;
+
+    UpdateDocumentCount();
+    for (int term_id = 0; term_id < static_cast<int>(word_to_document_freqs_.size()); ++term_id) {
+        UpdateWordDocumentFreq(term_id);
+    }
+    ++index_generation_;
 }
 
 bool SearchServer::IsStopWord( std::string_view word) const {
@@ -191,14 +435,17 @@ bool SearchServer::IsValidWord( std::string_view word) {
 std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop( std::string_view text) const
 {
     std::vector<std::string_view> words;
-    for (const auto word : SplitIntoWords(text)) {
-        if (!IsValidWord(word)) {
-            throw std::invalid_argument("Word " + static_cast<std::string>(word) + " is invalid");
-        }
-        if (!IsStopWord(word)) {
-            words.push_back(word);
-        }
+    // Разбиение и поиск недопустимых символов идут одним проходом по тексту
+    const size_t invalid_pos = SplitIntoWordsChecked(text, words);
+    if (invalid_pos != std::string_view::npos) {
+        const auto word = std::find_if(words.begin(), words.end(), [&text, invalid_pos](std::string_view word) {
+            return static_cast<size_t>(word.data() + word.size() - text.data()) > invalid_pos;
+        });
+        throw std::invalid_argument("Word " + static_cast<std::string>(*word) + " is invalid");
     }
+    words.erase(std::remove_if(words.begin(), words.end(), [this](std::string_view word) {
+        return IsStopWord(word);
+    }), words.end());
     return words;
 }
 
@@ -247,3 +494,93 @@ SearchServer::Query SearchServer::ParseQuery(std::string_view text) const {
 
     return result;
 }
+
+void SearchServer::ParseQuery(std::string_view text, QueryContext& context) const
+{
+    context.plus_words_.clear();
+    context.minus_words_.clear();
+    SplitIntoWords(text, context.words_);
+    for (const auto word : context.words_)
+    {
+        const auto query_word = ParseQueryWord(word);
+        if (!query_word.is_stop)
+        {
+            (query_word.is_minus ? context.minus_words_ : context.plus_words_).push_back(query_word.data);
+        }
+    }
+    std::sort(context.minus_words_.begin(), context.minus_words_.end());
+    context.minus_words_.erase(std::unique(context.minus_words_.begin(), context.minus_words_.end()), context.minus_words_.end());
+    std::sort(context.plus_words_.begin(), context.plus_words_.end());
+    context.plus_words_.erase(std::unique(context.plus_words_.begin(), context.plus_words_.end()), context.plus_words_.end());
+}
+
+bool SearchServer::ExcludeDocuments(const std::vector<std::string_view>& minus_words, QueryContext& context) const
+{
+    bool has_excluded = false;
+    for (const auto word : minus_words) {
+        const PostingList* postings = FindPostings(word);
+        if (postings == nullptr) {
+            continue;
+        }
+        for (const int document_index : postings->GetDocumentIds()) {
+            context.Exclude(document_index);
+            has_excluded = true;
+        }
+    }
+    return has_excluded;
+}
+
+void SearchServer::AccumulatePostings(const PostingList& postings, Relevance inverse_document_freq, bool has_excluded, QueryContext& context) const
+{
+    const auto& document_ids = postings.GetDocumentIds();
+    const auto& term_freqs = postings.GetTermFreqs();
+    // Без исключённых и ожидающих удаления документов блок подаётся в ядро как есть
+    const bool filter = has_excluded || pending_removed_count_ > 0;
+    int block_ids[SCORING_BLOCK_SIZE];
+    Relevance block_term_freqs[SCORING_BLOCK_SIZE];
+    // Ядро подсчитывает блок целиком, отметка документов идёт по тому же блоку, пока он в кеше
+    for (size_t first = 0; first < document_ids.size(); first += SCORING_BLOCK_SIZE) {
+        const size_t count = std::min(SCORING_BLOCK_SIZE, document_ids.size() - first);
+        const int* ids = document_ids.data() + first;
+        const Relevance* freqs = term_freqs.data() + first;
+        size_t kept = count;
+        if (filter) {
+            kept = 0;
+            for (size_t i = 0; i < count; ++i) {
+                if (!context.IsExcluded(ids[i]) && !document_removed_[ids[i]]) {
+                    block_ids[kept] = ids[i];
+                    block_term_freqs[kept] = freqs[i];
+                    ++kept;
+                }
+            }
+            ids = block_ids;
+            freqs = block_term_freqs;
+        }
+        AccumulateScores(ids, freqs, kept, inverse_document_freq, context.scores_.data());
+        context.MarkScored(ids, kept);
+    }
+}
+
+void SearchServer::NormalizeQuery(Query& query)
+{
+    std::sort(query.minus_words.begin(), query.minus_words.end());
+    query.minus_words.erase(std::unique(query.minus_words.begin(), query.minus_words.end()), query.minus_words.end());
+
+    std::sort(query.plus_words.begin(), query.plus_words.end());
+    query.plus_words.erase(std::unique(query.plus_words.begin(), query.plus_words.end()), query.plus_words.end());
+}
+
+std::string SearchServer::MakeQueryCacheKey(const Query& query, QueryMode mode, DocumentStatus status, size_t max_result_count)
+{
+    // Управляющие символы в словах запрещены, поэтому годятся как разделители
+    std::string key = std::to_string(static_cast<int>(mode)) + '\x01' + std::to_string(static_cast<int>(status)) + '\x01' + std::to_string(max_result_count);
+    for (const auto word : query.plus_words) {
+        key += '\x02';
+        key += word;
+    }
+    for (const auto word : query.minus_words) {
+        key += '\x03';
+        key += word;
+    }
+    return key;
+}
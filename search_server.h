@@ -5,9 +5,26 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
 #include <cmath>
+#include <exception>
+#include <limits>
 #include <execution>
-#include "concurentmap.h"
+#include <numeric>
+#include <thread>
+#include <type_traits>
+#include "document_bitmap.h"
+#include "forward_index.h"
+#include "score_table.h"
+#include "scoring_kernel.h"
+#include "posting_list.h"
+#include "query_cache.h"
+#include "query_context.h"
+#include "query_executor.h"
+#include "term_dictionary.h"
+#include "top_documents.h"
 
 #include "string_processing.h"
 #include "document.h"
@@ -15,7 +32,37 @@
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 
+// Как запрос сочетает плюс-слова
+enum class QueryMode {
+    // Документ содержит хотя бы одно плюс-слово
+    ANY,
+    // Документ содержит все плюс-слова
+    ALL,
+    // Как ANY, но с динамическим отсечением (MaxScore): документы, которые не могут попасть
+    // в выдачу, не досчитываются. Результат совпадает с ANY.
+    ANY_PRUNED,
+};
+
+// Документ для пакетного добавления через SearchServer::AddDocuments
+struct DocumentToAdd {
+    int id = 0;
+    std::string_view text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+};
+
+
+// Статистика всего корпуса для поиска по одному из сегментов (см. SegmentedSearchServer):
+// IDF считается по ней, чтобы релевантность не зависела от того, в какой сегмент попал документ
+struct CorpusStatistics {
+    int document_count = 0;
+    std::map<std::string_view, int> document_freqs;
 
+    Relevance ComputeInverseDocumentFreq(std::string_view word) const
+    {
+        return static_cast<Relevance>(std::log(static_cast<double>(document_count)) - std::log(static_cast<double>(document_freqs.at(word))));
+    }
+};
 
 class SearchServer {
 public:
@@ -34,32 +81,96 @@ public:
     explicit SearchServer(const std::string_view stop_words_text)
         : SearchServer(SplitIntoWords(stop_words_text)){ }
 
+    // Копия независима от оригинала и может изменяться, пока оригинал читают другие потоки.
+    // Кеш запросов не копируется: у копии он пустой с той же ёмкостью.
+    SearchServer(const SearchServer& other);
+
+    SearchServer(SearchServer&&) = default;
+
     void AddDocument(int document_id,  std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
 
+    // Пакетное добавление: разбор на слова и подсчёт TF идут параллельно, вставка в индекс - одним проходом.
+    // Проверки и исключения те же, что у AddDocument, но выполняются до изменения индекса:
+    // при ошибке не добавляется ни один документ пакета.
+    template <typename DocumentContainer>
+    void AddDocuments(const DocumentContainer& documents);
+
+    template <typename Policy, typename DocumentContainer>
+    void AddDocuments(const Policy policy, const DocumentContainer& documents);
+
+    // При немедленном удалении вхождения удаляются сразу, а места документа в столбцах
+    // и в прямом индексе освобождает Compact: он вызывается сам, когда удалённых мест больше половины.
     void RemoveDocument(int document_id);
 
+    // Отложенное удаление: RemoveDocument (любая перегрузка) за O(1) помечает документ удалённым,
+    // поиск его пропускает, а вхождения физически удаляет Compact. До Compact удалённые документы
+    // учитываются в IDF (и в числе документов, и в частотах слов).
+    // compaction_threshold > 0 - Compact вызывается сам, когда доля ожидающих удалённых документов выше порога.
+    // Выключение сразу вызывает Compact.
+    void SetDeferredRemoval(bool enabled, double compaction_threshold = 0.0);
+
+    // Удаляет вхождения удалённых документов и неиспользуемые слова, перенумеровывает документы подряд.
+    // Списки вхождений обрабатываются параллельно.
+    void Compact();
+
     void RemoveDocument(const std::execution::parallel_policy &, int document_id);
 
     void RemoveDocument(const std::execution::sequenced_policy &, int document_id);
 
-    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
 
     std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
 
     template <typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
 
+    // Policy - std::execution::seq, std::execution::par или ExecutorPolicy (QueryExecutor::GetPolicy())
     template <typename Policy, typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(const Policy exec_policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(const Policy exec_policy, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
 
     template <typename Policy>
-    std::vector<Document> FindTopDocuments(const Policy policy, std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(const Policy policy, std::string_view raw_query, DocumentStatus status, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
 
     template <typename Policy>
     std::vector<Document> FindTopDocuments(const Policy policy, std::string_view raw_query) const;
 
+    // Поиск в заданном режиме. QueryMode::ALL пересекает списки вхождений от самого короткого
+    // (галопирующим поиском) и считает релевантность только у документов из пересечения.
+    // QueryMode::ANY_PRUNED обходит документы по возрастанию и пропускает те, чья верхняя граница
+    // релевантности (сумма наибольших TF * IDF) ниже худшего из уже отобранных.
+    std::vector<Document> FindTopDocuments(QueryMode mode, std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(QueryMode mode, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    // Перегрузки с QueryContext выполняются последовательно, без кеша запросов, и в установившемся
+    // режиме не выделяют память. Возвращают ссылку на результат внутри контекста.
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    template <typename DocumentPredicate>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    // Добавляет в statistics число документов и частоты плюс-слов запроса в этом индексе.
+    // Документы, ожидающие отложенного удаления, учитываются и там, и там, как в локальном IDF
+    void CollectStatistics(std::string_view raw_query, CorpusStatistics& statistics) const;
+
+    // Поиск с IDF по статистике корпуса, собранной CollectStatistics со всех сегментов
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const CorpusStatistics& statistics, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
     int GetDocumentCount() const;
 
+    // Память словаря, списков вхождений, прямого индекса и столбцов документов
+    // (без хеш-таблицы id и кеша запросов)
+    size_t MemoryUsage() const;
+
+    // Кеш результатов FindTopDocuments со статусом: capacity - число запросов, 0 - отключить.
+    // Любое добавление или удаление документа сбрасывает кеш. Поиск не ждёт кеш, занятый
+    // другим потоком, а выполняется без него (счётчик contended).
+    void EnableQueryCache(size_t capacity);
+
+    QueryCacheStats GetQueryCacheStats() const;
+
     std::set<int>::const_iterator begin() const
     {
         return document_ids_.begin();
@@ -70,7 +181,18 @@ public:
         return document_ids_.end();
     }
 
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    // Слова документа с TF по возрастанию слов; действительно до изменения индекса
+    WordFrequenciesView GetWordFrequencies(int document_id) const;
+
+    // Бинарный снимок индекса: стоп-слова, документы и списки вхождений.
+    // LoadSnapshot отображает файл в память и копирует списки вхождений целыми массивами,
+    // без повторного разбора текстов. SaveSnapshot пишет во временный файл path + ".tmp"
+    // и переименовывает его поверх path. При ошибке чтения или записи, а также для повреждённого
+    // снимка (повторяющиеся или отрицательные id, неизвестный статус, неупорядоченные списки
+    // вхождений, недопустимые слова и стоп-слова, TF вне (0, 1]) бросает std::runtime_error.
+    void SaveSnapshot(const std::string& path) const;
+
+    static SearchServer LoadSnapshot(const std::string& path);
 
     std::tuple< std::vector< std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
 
@@ -78,20 +200,59 @@ public:
 
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::sequenced_policy &, std::string_view raw_query,int document_id) const;
 
+    std::tuple<const std::vector<std::string_view>&, DocumentStatus> MatchDocument(QueryContext& context, std::string_view raw_query, int document_id) const;
+
 
 
 
 private:
-    struct DocumentData {
-        int rating;
-        DocumentStatus status;
-    };
-    std::map<std::string, std::pair<std::string, std::string_view>> words_in_docs_;
+    // Сжимает сегменты из индекса
+    friend class FrozenSegment;
+    // Разбирает запрос один раз для всех сегментов
+    friend class SegmentedSearchServer;
+
     const std::set<std::string, std::less<>> stop_words_;
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, DocumentData> documents_;
+    // Все слова документов; остальной индекс ссылается на них по id термина
+    TermDictionary terms_;
+    // Списки вхождений по id термина; хранят внутренние индексы документов, а не внешние id
+    std::vector<PostingList> word_to_document_freqs_;
+    // Кеш для IDF = log(N) - log(df): логарифмы обновляются при изменении индекса, а не при каждом запросе
+    std::vector<double> word_log_document_freqs_;
+    double log_document_count_ = 0.0;
+
+    // Поколение индекса растёт при каждом изменении, по нему сбрасывается кеш запросов
+    uint64_t index_generation_ = 0;
+    std::unique_ptr<QueryCache> query_cache_;
     std::set<int> document_ids_;
-    std::map<int,std::map<std::string_view, double>> document_and_word;
+
+    // Внутренняя плотная нумерация: внешний id -> индекс в столбцах ниже.
+    // Индексы выдаются по возрастанию и не переиспользуются после удаления.
+    std::unordered_map<int, int> document_indices_;
+    std::vector<int> document_external_ids_;
+    std::vector<int> document_ratings_;
+    std::vector<DocumentStatus> document_statuses_;
+    // Число слов документа без стоп-слов: TF = число вхождений * (1.0 / длина)
+    std::vector<int> document_word_counts_;
+    // Слова каждого документа: id терминов и TF в общих массивах
+    ForwardIndex forward_index_;
+    // Удалённые документы; при отложенном удалении их вхождения остаются до Compact
+    std::vector<bool> document_removed_;
+    // Удалённые документы, чьи места в столбцах и прямом индексе ещё не освобождены Compact
+    size_t removed_slot_count_ = 0;
+    size_t pending_removed_count_ = 0;
+    bool removal_deferred_ = false;
+    double compaction_threshold_ = 0.0;
+
+    int FindDocumentIndex(int document_id) const;
+
+    // Список вхождений слова или nullptr, если слово не встречалось
+    const PostingList* FindPostings(std::string_view word) const;
+
+    void RemoveDocumentData(int document_id, int document_index);
+
+    void UpdateWordDocumentFreq(int term_id);
+
+    void UpdateDocumentCount();
 
 
 
@@ -104,6 +265,18 @@ private:
 
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
+    using WordFrequencies = std::vector<std::pair<std::string_view, Relevance>>;
+
+    struct DocumentWords {
+        WordFrequencies word_freqs;
+        int word_count = 0;
+    };
+
+    // Слова документа без стоп-слов, отсортированные, с TF, и их общее число
+    DocumentWords ComputeWordFrequencies(std::string_view document) const;
+
+    void InsertDocument(int document_id, DocumentStatus status, int rating, const DocumentWords& words);
+
     struct QueryWord {
         std::string_view data;
         bool is_minus;
@@ -120,101 +293,486 @@ private:
 
     Query ParseQuery(std::string_view text) const;
 
+    // Разбор в буферы контекста, плюс- и минус-слова сразу нормализуются
+    void ParseQuery(std::string_view text, QueryContext& context) const;
+
+    // Отмечает в контексте документы с минус-словами; false, если таких нет
+    bool ExcludeDocuments(const std::vector<std::string_view>& minus_words, QueryContext& context) const;
+
+    // Подсчёт по списку вхождений в плотный накопитель контекста блоками через ядро.
+    // Исключённые и ожидающие удаления документы отбрасываются из блока до подсчёта
+    void AccumulatePostings(const PostingList& postings, Relevance inverse_document_freq, bool has_excluded, QueryContext& context) const;
+
+    // Сортирует плюс- и минус-слова и убирает повторы
+    static void NormalizeQuery(Query& query);
+
+    static std::string MakeQueryCacheKey(const Query& query, QueryMode mode, DocumentStatus status, size_t max_result_count);
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(QueryMode mode, const Query& query, DocumentPredicate document_predicate, size_t max_result_count) const;
+
+    // Документы, содержащие все плюс-слова запроса
+    template <typename DocumentPredicate>
+    std::vector<Document> FindConjunctiveDocuments(const Query& query, DocumentPredicate document_predicate) const;
+
+    // Отбор лучших документов запроса по алгоритму MaxScore
+    template <typename DocumentPredicate>
+    std::vector<Document> FindPrunedTopDocuments(const Query& query, DocumentPredicate document_predicate, size_t max_result_count) const;
+
+    // statistics == nullptr - IDF по самому индексу
+    template <typename Policy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const Policy policy, const Query& query, DocumentPredicate document_predicate, size_t max_result_count, const CorpusStatistics* statistics = nullptr) const;
 
-    double ComputeWordInverseDocumentFreq(std::string_view text) const {
-        return  log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(text).size());
+
+    Relevance ComputeWordInverseDocumentFreq(int term_id) const {
+        return static_cast<Relevance>(log_document_count_ - word_log_document_freqs_[term_id]);
     }
     template <typename DocumentPredicate>
     std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
     template <typename Policy,typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Policy policy,const Query& query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindAllDocuments(const Policy policy,const Query& query, DocumentPredicate document_predicate, const CorpusStatistics* statistics = nullptr) const;
 };
 
+template <typename DocumentContainer>
+void SearchServer::AddDocuments(const DocumentContainer& documents) {
+    AddDocuments(std::execution::seq, documents);
+}
+
+template <typename Policy, typename DocumentContainer>
+void SearchServer::AddDocuments(const Policy policy, const DocumentContainer& documents) {
+    std::vector<int> new_ids;
+    for (const auto& document : documents) {
+        if ((document.id < 0) || (document_indices_.count(document.id) > 0)) {
+            throw std::invalid_argument("Invalid document_id");
+        }
+        new_ids.push_back(document.id);
+    }
+    std::sort(new_ids.begin(), new_ids.end());
+    if (std::adjacent_find(new_ids.begin(), new_ids.end()) != new_ids.end()) {
+        throw std::invalid_argument("Invalid document_id");
+    }
+
+    struct ParsedDocument {
+        DocumentWords words;
+        int rating = 0;
+        std::exception_ptr error;
+    };
+    // Исключение нельзя выпускать из параллельного алгоритма - сохраняем и бросаем после
+    std::vector<ParsedDocument> parsed(new_ids.size());
+    std::transform(policy, std::begin(documents), std::end(documents), parsed.begin(), [this](const auto& document) {
+        ParsedDocument result;
+        try {
+            result.words = ComputeWordFrequencies(document.text);
+            result.rating = ComputeAverageRating(document.ratings);
+        } catch (...) {
+            result.error = std::current_exception();
+        }
+        return result;
+    });
+    for (const auto& document : parsed) {
+        if (document.error) {
+            std::rethrow_exception(document.error);
+        }
+    }
+
+    auto parsed_it = parsed.begin();
+    for (const auto& document : documents) {
+        InsertDocument(document.id, document.status, parsed_it->rating, parsed_it->words);
+        ++parsed_it;
+    }
+}
+
+template <typename DocumentPredicate>
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_result_count) const {
+    ParseQuery(raw_query, context);
+    context.Prepare(document_external_ids_.size());
+
+    const bool has_excluded = ExcludeDocuments(context.minus_words_, context);
+    for (const auto word : context.plus_words_) {
+        const int term_id = terms_.Find(word);
+        if (term_id < 0 || word_to_document_freqs_[term_id].empty()) {
+            continue;
+        }
+        AccumulatePostings(word_to_document_freqs_[term_id], ComputeWordInverseDocumentFreq(term_id), has_excluded, context);
+    }
+
+    // Предикат проверяется один раз на документ, а не на каждое вхождение
+    context.selector_.Reset(max_result_count);
+    context.ForEachScored([this, &context, &document_predicate](int document_index, Relevance relevance) {
+        if (document_predicate(document_external_ids_[document_index], document_statuses_[document_index], document_ratings_[document_index])) {
+            context.selector_.Add({document_external_ids_[document_index], relevance, document_ratings_[document_index]});
+        }
+    });
+    context.Reset();
+    return context.selector_.Sort();
+}
+
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
-    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t max_result_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, max_result_count);
 }
 
 template <typename Policy,typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(const  Policy policy,std::string_view raw_query, DocumentPredicate document_predicate) const {
-     auto query = ParseQuery(raw_query);
+std::vector<Document> SearchServer::FindTopDocuments(const  Policy policy,std::string_view raw_query, DocumentPredicate document_predicate, size_t max_result_count) const {
+    auto query = ParseQuery(raw_query);
+    NormalizeQuery(query);
+    return FindTopDocuments(policy, query, document_predicate, max_result_count);
+}
 
-     sort(query.minus_words.begin(),query.minus_words.end());
-     auto f = std::unique(query.minus_words.begin(),query.minus_words.end());
-     query.minus_words.erase(f, query.minus_words.end());
+template <typename Policy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const Policy policy, const Query& query, DocumentPredicate document_predicate, size_t max_result_count, const CorpusStatistics* statistics) const {
+    const auto matched_documents = FindAllDocuments(policy, query, document_predicate, statistics);
 
-     sort(query.plus_words.begin(),query.plus_words.end());
-     auto f1 = std::unique(query.plus_words.begin(),query.plus_words.end());
-     query.plus_words.erase(f1, query.plus_words.end());
+    return SelectTopDocuments(policy, matched_documents, max_result_count);
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const CorpusStatistics& statistics, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_result_count) const {
+    auto query = ParseQuery(raw_query);
+    NormalizeQuery(query);
+    return FindTopDocuments(std::execution::seq, query, document_predicate, max_result_count, &statistics);
+}
 
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(QueryMode mode, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_result_count) const {
+    auto query = ParseQuery(raw_query);
+    NormalizeQuery(query);
+    return FindTopDocuments(mode, query, document_predicate, max_result_count);
+}
 
-    auto matched_documents = FindAllDocuments(policy, query, document_predicate);
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(QueryMode mode, const Query& query, DocumentPredicate document_predicate, size_t max_result_count) const {
+    if (mode == QueryMode::ALL) {
+        return SelectTopDocuments(std::execution::seq, FindConjunctiveDocuments(query, document_predicate), max_result_count);
+    }
+    if (mode == QueryMode::ANY_PRUNED) {
+        return FindPrunedTopDocuments(query, document_predicate, max_result_count);
+    }
+    return FindTopDocuments(std::execution::seq, query, document_predicate, max_result_count);
+}
 
-    std::sort(policy, matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
-        if (std::abs(lhs.relevance - rhs.relevance) < 1e-6) {
-            return lhs.rating > rhs.rating;
-        } else {
-            return lhs.relevance > rhs.relevance;
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindConjunctiveDocuments(const Query& query, DocumentPredicate document_predicate) const {
+    std::vector<std::pair<const PostingList*, Relevance>> plus_postings;
+    for (const auto word : query.plus_words) {
+        const int term_id = terms_.Find(word);
+        if (term_id < 0 || word_to_document_freqs_[term_id].empty()) {
+            return {};
         }
+        plus_postings.push_back({&word_to_document_freqs_[term_id], ComputeWordInverseDocumentFreq(term_id)});
+    }
+    if (plus_postings.empty()) {
+        return {};
+    }
+
+    // Пересечение от самого короткого списка: кандидатов не больше, чем в нём
+    std::vector<const PostingList*> by_size;
+    for (const auto& [postings, inverse_document_freq] : plus_postings) {
+        by_size.push_back(postings);
+    }
+    std::sort(by_size.begin(), by_size.end(), [](const PostingList* lhs, const PostingList* rhs) {
+        return lhs->size() < rhs->size();
     });
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    std::vector<int> document_indices;
+    for (const int document_index : by_size.front()->GetDocumentIds()) {
+        if (!document_removed_[document_index]
+            && document_predicate(document_external_ids_[document_index], document_statuses_[document_index], document_ratings_[document_index])) {
+            document_indices.push_back(document_index);
+        }
+    }
+    const auto retain = [&document_indices](const PostingList& postings, bool contained) {
+        const auto& document_ids = postings.GetDocumentIds();
+        size_t pos = 0;
+        size_t kept = 0;
+        for (const int document_index : document_indices) {
+            pos = GallopLowerBound(document_ids, pos, document_index);
+            if ((pos < document_ids.size() && document_ids[pos] == document_index) == contained) {
+                document_indices[kept++] = document_index;
+            }
+        }
+        document_indices.resize(kept);
+    };
+    for (auto it = by_size.begin() + 1; it != by_size.end() && !document_indices.empty(); ++it) {
+        retain(**it, true);
+    }
+    for (const auto word : query.minus_words) {
+        const PostingList* postings = FindPostings(word);
+        if (postings != nullptr && !document_indices.empty()) {
+            retain(*postings, false);
+        }
     }
 
+    // Релевантность суммируется в порядке плюс-слов, как в режиме ANY, поэтому совпадает с ним точно
+    std::vector<Relevance> relevances(document_indices.size());
+    for (const auto& [postings, inverse_document_freq] : plus_postings) {
+        const auto& document_ids = postings->GetDocumentIds();
+        const auto& term_freqs = postings->GetTermFreqs();
+        size_t pos = 0;
+        for (size_t i = 0; i < document_indices.size(); ++i) {
+            pos = GallopLowerBound(document_ids, pos, document_indices[i]);
+            relevances[i] += term_freqs[pos] * inverse_document_freq;
+        }
+    }
+    std::vector<Document> matched_documents;
+    matched_documents.reserve(document_indices.size());
+    for (size_t i = 0; i < document_indices.size(); ++i) {
+        const int document_index = document_indices[i];
+        matched_documents.push_back({document_external_ids_[document_index], relevances[i], document_ratings_[document_index]});
+    }
     return matched_documents;
 }
 
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindPrunedTopDocuments(const Query& query, DocumentPredicate document_predicate, size_t max_result_count) const {
+    struct TermCursor {
+        const std::vector<int>* document_ids;
+        const std::vector<Relevance>* term_freqs;
+        Relevance inverse_document_freq;
+        // Наибольший возможный вклад слова в релевантность
+        Relevance upper_bound;
+        // Номер слова в запросе: релевантность суммируется в порядке плюс-слов, как в режиме ANY
+        size_t order;
+        size_t pos;
+    };
+    std::vector<TermCursor> terms;
+    for (const auto word : query.plus_words) {
+        const int term_id = terms_.Find(word);
+        if (term_id < 0 || word_to_document_freqs_[term_id].empty()) {
+            continue;
+        }
+        const PostingList& postings = word_to_document_freqs_[term_id];
+        const Relevance inverse_document_freq = ComputeWordInverseDocumentFreq(term_id);
+        terms.push_back({&postings.GetDocumentIds(), &postings.GetTermFreqs(), inverse_document_freq,
+                         postings.GetMaxTermFreq() * inverse_document_freq, terms.size(), 0});
+    }
+    std::vector<std::pair<const std::vector<int>*, size_t>> minus_cursors;
+    for (const auto word : query.minus_words) {
+        const PostingList* postings = FindPostings(word);
+        if (postings != nullptr) {
+            minus_cursors.push_back({&postings->GetDocumentIds(), 0});
+        }
+    }
+
+    // Слова по возрастанию верхней границы; bound_sums[i] - сумма границ слов 0..i
+    std::sort(terms.begin(), terms.end(), [](const TermCursor& lhs, const TermCursor& rhs) {
+        return lhs.upper_bound < rhs.upper_bound;
+    });
+    std::vector<Relevance> bound_sums(terms.size());
+    for (size_t i = 0; i < terms.size(); ++i) {
+        bound_sums[i] = (i == 0 ? Relevance{0} : bound_sums[i - 1]) + terms[i].upper_bound;
+    }
+
+    TopDocumentsSelector selector(max_result_count);
+    // Отсечение с запасом на погрешность округления сверх порога сравнения IsMoreRelevant:
+    // отброшенный документ не вытеснил бы худшего из отобранных и при полном подсчёте
+    Relevance threshold = -std::numeric_limits<Relevance>::infinity();
+    // Слова [0, essential) необязательные: документ, который есть только в них, не наберёт порог.
+    // Кандидаты берутся из списков остальных слов.
+    size_t essential = 0;
+    std::vector<Relevance> contributions(terms.size());
+    while (essential < terms.size()) {
+        int document_index = std::numeric_limits<int>::max();
+        for (size_t i = essential; i < terms.size(); ++i) {
+            if (terms[i].pos < terms[i].document_ids->size()) {
+                document_index = std::min(document_index, (*terms[i].document_ids)[terms[i].pos]);
+            }
+        }
+        if (document_index == std::numeric_limits<int>::max()) {
+            break;
+        }
+
+        Relevance score = 0.0;
+        std::fill(contributions.begin(), contributions.end(), 0.0);
+        for (size_t i = essential; i < terms.size(); ++i) {
+            TermCursor& term = terms[i];
+            if (term.pos < term.document_ids->size() && (*term.document_ids)[term.pos] == document_index) {
+                contributions[term.order] = (*term.term_freqs)[term.pos] * term.inverse_document_freq;
+                score += contributions[term.order];
+                ++term.pos;
+            }
+        }
+        if (document_removed_[document_index]
+            || !document_predicate(document_external_ids_[document_index], document_statuses_[document_index], document_ratings_[document_index])) {
+            continue;
+        }
+        bool pruned = false;
+        for (size_t i = essential; i-- > 0;) {
+            if (score + bound_sums[i] < threshold) {
+                pruned = true;
+                break;
+            }
+            TermCursor& term = terms[i];
+            term.pos = GallopLowerBound(*term.document_ids, term.pos, document_index);
+            if (term.pos < term.document_ids->size() && (*term.document_ids)[term.pos] == document_index) {
+                contributions[term.order] = (*term.term_freqs)[term.pos] * term.inverse_document_freq;
+                score += contributions[term.order];
+            }
+        }
+        if (pruned || score < threshold) {
+            continue;
+        }
+        const bool excluded = std::any_of(minus_cursors.begin(), minus_cursors.end(), [document_index](auto& cursor) {
+            cursor.second = GallopLowerBound(*cursor.first, cursor.second, document_index);
+            return cursor.second < cursor.first->size() && (*cursor.first)[cursor.second] == document_index;
+        });
+        if (excluded) {
+            continue;
+        }
+
+        Relevance relevance = 0.0;
+        for (const Relevance contribution : contributions) {
+            if (contribution != 0.0) {
+                relevance += contribution;
+            }
+        }
+        selector.Add({document_external_ids_[document_index], relevance, document_ratings_[document_index]});
+        if (const Document* worst = selector.GetWorst()) {
+            threshold = worst->relevance - 2 * GetRelevanceTolerance(worst->relevance);
+            const size_t previous_essential = essential;
+            essential = 0;
+            while (essential < terms.size() && bound_sums[essential] < threshold) {
+                ++essential;
+            }
+            // Порог может немного снизиться (при почти равной релевантности решает рейтинг):
+            // снова обязательные слова продолжают обход после текущего документа
+            for (size_t i = essential; i < previous_essential; ++i) {
+                terms[i].pos = GallopLowerBound(*terms[i].document_ids, terms[i].pos, document_index + 1);
+            }
+        }
+    }
+    return selector.Extract();
+}
+
 template <typename Policy>
 std::vector<Document> SearchServer::FindTopDocuments(const  Policy policy, std::string_view raw_query) const {
     return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
 }
 template <typename Policy>
-std::vector<Document> SearchServer::FindTopDocuments(const  Policy policy, std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(policy, raw_query, [status](int document_id, DocumentStatus statusp, int rating) { return statusp == status; });
+std::vector<Document> SearchServer::FindTopDocuments(const  Policy policy, std::string_view raw_query, DocumentStatus status, size_t max_result_count) const {
+    const auto predicate = [status](int, DocumentStatus document_status, int) { return document_status == status; };
+    if (!query_cache_) {
+        return FindTopDocuments(policy, raw_query, predicate, max_result_count);
+    }
+    auto query = ParseQuery(raw_query);
+    NormalizeQuery(query);
+    const std::string key = MakeQueryCacheKey(query, QueryMode::ANY, status, max_result_count);
+    const uint64_t generation = index_generation_;
+    if (auto cached = query_cache_->Find(key, generation)) {
+        return std::move(*cached);
+    }
+    auto result = FindTopDocuments(policy, query, predicate, max_result_count);
+    query_cache_->Insert(key, generation, result);
+    return result;
 }
 template <typename DocumentPredicate>
 std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const {
-    FindAllDocuments(std::execution::seq,query, document_predicate);
+    return FindAllDocuments(std::execution::seq,query, document_predicate);
 }
 
 
 
 template <typename Policy, typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Policy policy,const Query& query, DocumentPredicate document_predicate) const {
+std::vector<Document> SearchServer::FindAllDocuments(const Policy policy,const Query& query, DocumentPredicate document_predicate, const CorpusStatistics* statistics) const {
+
+    std::vector<std::pair<const PostingList*, Relevance>> plus_postings;
+    size_t posting_count = 0;
+    for (const auto word : query.plus_words) {
+        const int term_id = terms_.Find(word);
+        if (term_id < 0 || word_to_document_freqs_[term_id].empty()) {
+            continue;
+        }
+        const Relevance inverse_document_freq = statistics == nullptr ? ComputeWordInverseDocumentFreq(term_id) : statistics->ComputeInverseDocumentFreq(word);
+        plus_postings.push_back({&word_to_document_freqs_[term_id], inverse_document_freq});
+        posting_count += word_to_document_freqs_[term_id].size();
+    }
+    std::vector<Document> matched_documents;
+    if (plus_postings.empty()) {
+        return matched_documents;
+    }
 
-    ConcurrentMap<int, double> document_to_relevance(16);
-    std::for_each(policy, query.plus_words.begin(), query.plus_words.end(),[this, &document_to_relevance, &document_predicate](auto word)
-    {
-        if (word_to_document_freqs_.count(word) == 0) {
-            return ;
+    size_t part_count = 1;
+    if constexpr (std::is_same_v<std::decay_t<Policy>, std::execution::parallel_policy>) {
+        part_count = std::max(1u, std::thread::hardware_concurrency());
+    } else if constexpr (std::is_same_v<std::decay_t<Policy>, ExecutorPolicy>) {
+        part_count = policy.executor->GetWorkerCount();
+    }
+
+    if (part_count == 1) {
+        // Плотный накопитель потока переиспользуется между запросами и обнуляется только
+        // по затронутым документам, поэтому запрос стоит порядка числа вхождений.
+        // Предикат вызывается после сброса накопителя: он может сам обращаться к поиску
+        thread_local QueryContext context;
+        context.Prepare(document_external_ids_.size());
+        const bool has_excluded = ExcludeDocuments(query.minus_words, context);
+        for (const auto& [postings, inverse_document_freq] : plus_postings) {
+            AccumulatePostings(*postings, inverse_document_freq, has_excluded, context);
+        }
+        std::vector<std::pair<int, Relevance>> scored;
+        context.ForEachScored([&scored](int document_index, Relevance relevance) {
+            scored.push_back({document_index, relevance});
+        });
+        context.Reset();
+        matched_documents.reserve(scored.size());
+        for (const auto& [document_index, relevance] : scored) {
+            if (document_predicate(document_external_ids_[document_index], document_statuses_[document_index], document_ratings_[document_index])) {
+                matched_documents.push_back({document_external_ids_[document_index], relevance, document_ratings_[document_index]});
+            }
         }
-         const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-         for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-             const auto& document_data = documents_.at(document_id);
-             if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                 document_to_relevance[document_id].ref_to_value +=  static_cast<double>(term_freq * inverse_document_freq);
-             }
-         }
+        return matched_documents;
+    }
 
-    });
-    std::for_each(policy, query.minus_words.begin(), query.minus_words.end(),[this, &document_to_relevance](auto word)
-    {
-        if (word_to_document_freqs_.count(word) == 0) {
-            return;
+    // Документы с минус-словами отмечаются до подсчёта и не попадают в таблицы релевантности
+    DocumentBitmap excluded;
+    for (const auto word : query.minus_words) {
+        const PostingList* postings = FindPostings(word);
+        if (postings == nullptr || postings->empty()) {
+            continue;
+        }
+        if (excluded.empty()) {
+            excluded = DocumentBitmap(document_external_ids_.size());
         }
-        for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
+        for (const int document_index : postings->GetDocumentIds()) {
+            excluded.Set(document_index);
         }
+    }
 
-    });
+    // Каждый поток копит релевантность в своей таблице по своей доле каждого списка вхождений,
+    // таблицы сливаются один раз в конце
+    const auto accumulate = [this, &plus_postings, &excluded, &document_predicate](ScoreTable& document_to_relevance, size_t part, size_t part_count) {
+        const bool has_excluded = !excluded.empty();
+        for (const auto& [postings, inverse_document_freq] : plus_postings) {
+            const auto& document_ids = postings->GetDocumentIds();
+            const auto& term_freqs = postings->GetTermFreqs();
+            const size_t last = document_ids.size() * (part + 1) / part_count;
+            for (size_t i = document_ids.size() * part / part_count; i < last; ++i) {
+                const int document_index = document_ids[i];
+                if (!(has_excluded && excluded.Test(document_index)) && !document_removed_[document_index]
+                    && document_predicate(document_external_ids_[document_index], document_statuses_[document_index], document_ratings_[document_index])) {
+                    document_to_relevance[document_index] += term_freqs[i] * inverse_document_freq;
+                }
+            }
+        }
+    };
 
-    std::vector<Document> matched_documents;
-    auto map_one_result = document_to_relevance.BuildOrdinaryMap();
-    for (const auto [document_id, relevance] : map_one_result) {
-        matched_documents.push_back({document_id, relevance, documents_.at(document_id).rating});
+    std::vector<ScoreTable> tables(part_count, ScoreTable(posting_count / part_count));
+    const auto accumulate_part = [&tables, &accumulate, part_count](size_t part) {
+        accumulate(tables[part], part, part_count);
+    };
+    if constexpr (std::is_same_v<std::decay_t<Policy>, ExecutorPolicy>) {
+        policy.executor->ParallelFor(part_count, accumulate_part);
+    } else {
+        std::vector<size_t> parts(part_count);
+        std::iota(parts.begin(), parts.end(), 0);
+        std::for_each(policy, parts.begin(), parts.end(), accumulate_part);
     }
+    for (size_t part = 1; part < part_count; ++part) {
+        tables[0].Merge(tables[part]);
+    }
+    ScoreTable& document_to_relevance = tables[0];
+
+    matched_documents.reserve(document_to_relevance.size());
+    document_to_relevance.ForEach([this, &matched_documents](int document_index, Relevance relevance) {
+        matched_documents.push_back({document_external_ids_[document_index], relevance, document_ratings_[document_index]});
+    });
     return matched_documents;
 }
-
-
-
@@ -0,0 +1,411 @@
+#include "search_server.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Формат снимка (порядок байт платформы, проверяется маркером):
+//   заголовок:  magic[8] "SRCHSNAP", uint32 версия, uint32 маркер порядка байт
+//   стоп-слова: uint64 число, затем для каждого uint32 длина и байты
+//   документы:  uint64 число, массивы int32 внешних id, рейтингов, статусов и длин (слов без стоп-слов)
+//   слова:      uint64 число, затем для каждого uint32 длина, байты, uint64 число вхождений,
+//               массив int32 индексов документов и массив double TF (при сборке с float TF
+//               преобразуются, поэтому снимки переносимы между сборками)
+// Массивы выровнены по 8 байт относительно начала файла, поэтому при загрузке
+// через mmap их можно читать на месте.
+// Снимок пишется во временный файл рядом с целевым и переименовывается поверх него,
+// поэтому сбой во время записи не портит предыдущий снимок.
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[8] = {'S', 'R', 'C', 'H', 'S', 'N', 'A', 'P'};
+constexpr uint32_t SNAPSHOT_VERSION = 2;
+constexpr uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+constexpr size_t SNAPSHOT_ALIGNMENT = 8;
+
+// TF в снимке хранятся как double; при сборке с другим Relevance они копируются в buffer
+template <typename T>
+const T* ConvertTermFreqs(const double* term_freqs, size_t size, std::vector<T>& buffer)
+{
+    if constexpr (std::is_same_v<T, double>) {
+        return term_freqs;
+    } else {
+        buffer.assign(term_freqs, term_freqs + size);
+        return buffer.data();
+    }
+}
+
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(const std::string& path)
+        : path_(path)
+        , temp_path_(path + ".tmp")
+        , out_(temp_path_, std::ios::binary | std::ios::trunc)
+    {
+        if (!out_) {
+            throw std::runtime_error("Cannot open snapshot file " + temp_path_);
+        }
+    }
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    // Незавершённая запись оставляет предыдущий снимок нетронутым
+    ~SnapshotWriter()
+    {
+        if (!finished_) {
+            out_.close();
+            std::remove(temp_path_.c_str());
+        }
+    }
+
+    template <typename T>
+    void Write(const T& value)
+    {
+        WriteBytes(&value, sizeof(value));
+    }
+
+    void WriteString(std::string_view str)
+    {
+        Write(static_cast<uint32_t>(str.size()));
+        WriteBytes(str.data(), str.size());
+    }
+
+    template <typename T>
+    void WriteArray(const T* data, size_t size)
+    {
+        Align();
+        WriteBytes(data, size * sizeof(T));
+    }
+
+    // Дописывает файл на диск и атомарно заменяет им целевой
+    void Finish()
+    {
+        out_.close();
+        if (!out_) {
+            throw std::runtime_error("Snapshot write failed");
+        }
+        const int fd = open(temp_path_.c_str(), O_RDONLY);
+        const bool synced = fd >= 0 && fsync(fd) == 0;
+        if (fd >= 0) {
+            close(fd);
+        }
+        if (!synced || std::rename(temp_path_.c_str(), path_.c_str()) != 0) {
+            throw std::runtime_error("Snapshot write failed");
+        }
+        finished_ = true;
+    }
+
+private:
+    std::string path_;
+    std::string temp_path_;
+    std::ofstream out_;
+    bool finished_ = false;
+    size_t offset_ = 0;
+
+    void WriteBytes(const void* data, size_t size)
+    {
+        out_.write(static_cast<const char*>(data), size);
+        offset_ += size;
+    }
+
+    void Align()
+    {
+        static const char padding[SNAPSHOT_ALIGNMENT] = {};
+        WriteBytes(padding, (SNAPSHOT_ALIGNMENT - offset_ % SNAPSHOT_ALIGNMENT) % SNAPSHOT_ALIGNMENT);
+    }
+};
+
+// Файл, отображённый в память только для чтения
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path)
+    {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open snapshot file " + path);
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0) {
+            close(fd);
+            throw std::runtime_error("Cannot stat snapshot file " + path);
+        }
+        size_ = static_cast<size_t>(file_stat.st_size);
+        if (size_ > 0) {
+            void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Cannot map snapshot file " + path);
+            }
+            data_ = static_cast<const char*>(data);
+        }
+        close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        if (data_ != nullptr) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    const char* data() const
+    {
+        return data_;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+class SnapshotReader {
+public:
+    explicit SnapshotReader(const MappedFile& file)
+        : data_(file.data()), size_(file.size())
+    {
+    }
+
+    template <typename T>
+    T Read()
+    {
+        T value;
+        std::memcpy(&value, Take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    // Число элементов не больше, чем их может поместиться в остатке файла
+    size_t ReadCount(size_t min_element_size)
+    {
+        const uint64_t count = Read<uint64_t>();
+        if (count > (size_ - offset_) / min_element_size) {
+            throw std::runtime_error("Snapshot is truncated");
+        }
+        return static_cast<size_t>(count);
+    }
+
+    std::string_view ReadString()
+    {
+        const uint32_t size = Read<uint32_t>();
+        return {Take(size), size};
+    }
+
+    template <typename T>
+    const T* ReadArray(size_t size)
+    {
+        Take((SNAPSHOT_ALIGNMENT - offset_ % SNAPSHOT_ALIGNMENT) % SNAPSHOT_ALIGNMENT);
+        if (size > (size_ - offset_) / sizeof(T)) {
+            throw std::runtime_error("Snapshot is truncated");
+        }
+        return reinterpret_cast<const T*>(Take(size * sizeof(T)));
+    }
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t offset_ = 0;
+
+    const char* Take(size_t size)
+    {
+        if (size > size_ - offset_) {
+            throw std::runtime_error("Snapshot is truncated");
+        }
+        const char* result = data_ + offset_;
+        offset_ += size;
+        return result;
+    }
+};
+
+} // namespace
+
+void SearchServer::SaveSnapshot(const std::string& path) const
+{
+    // Индексы удалённых документов в снимок не попадают, оставшиеся нумеруются подряд
+    std::vector<int> new_indices(document_external_ids_.size(), -1);
+    std::vector<int> ids;
+    std::vector<int> ratings;
+    std::vector<int32_t> statuses;
+    std::vector<int> word_counts;
+    for (int index = 0; index < static_cast<int>(document_external_ids_.size()); ++index) {
+        if (document_removed_[index]) {
+            continue;
+        }
+        new_indices[index] = static_cast<int>(ids.size());
+        ids.push_back(document_external_ids_[index]);
+        ratings.push_back(document_ratings_[index]);
+        statuses.push_back(static_cast<int32_t>(document_statuses_[index]));
+        word_counts.push_back(document_word_counts_[index]);
+    }
+
+    SnapshotWriter writer(path);
+    for (const char c : SNAPSHOT_MAGIC) {
+        writer.Write(c);
+    }
+    writer.Write(SNAPSHOT_VERSION);
+    writer.Write(SNAPSHOT_BYTE_ORDER);
+
+    writer.Write(static_cast<uint64_t>(stop_words_.size()));
+    for (const std::string& word : stop_words_) {
+        writer.WriteString(word);
+    }
+
+    writer.Write(static_cast<uint64_t>(ids.size()));
+    writer.WriteArray(ids.data(), ids.size());
+    writer.WriteArray(ratings.data(), ratings.size());
+    writer.WriteArray(statuses.data(), statuses.size());
+    writer.WriteArray(word_counts.data(), word_counts.size());
+
+    // Слова пишутся в алфавитном порядке: при загрузке по нему строятся словари документов
+    std::vector<int> term_ids;
+    for (int term_id = 0; term_id < static_cast<int>(word_to_document_freqs_.size()); ++term_id) {
+        if (!word_to_document_freqs_[term_id].empty()) {
+            term_ids.push_back(term_id);
+        }
+    }
+    std::sort(term_ids.begin(), term_ids.end(), [this](int lhs, int rhs) {
+        return terms_.GetTerm(lhs) < terms_.GetTerm(rhs);
+    });
+    writer.Write(static_cast<uint64_t>(term_ids.size()));
+    std::vector<int> document_indices;
+    std::vector<double> term_freqs;
+    for (const int term_id : term_ids) {
+        const PostingList& postings = word_to_document_freqs_[term_id];
+        // При отложенном удалении в списках ещё есть вхождения удалённых документов
+        document_indices.clear();
+        term_freqs.clear();
+        for (size_t i = 0; i < postings.size(); ++i) {
+            const int index = new_indices[postings.GetDocumentIds()[i]];
+            if (index >= 0) {
+                document_indices.push_back(index);
+                term_freqs.push_back(postings.GetTermFreqs()[i]);
+            }
+        }
+        writer.WriteString(terms_.GetTerm(term_id));
+        writer.Write(static_cast<uint64_t>(document_indices.size()));
+        writer.WriteArray(document_indices.data(), document_indices.size());
+        writer.WriteArray(term_freqs.data(), term_freqs.size());
+    }
+    writer.Finish();
+}
+
+SearchServer SearchServer::LoadSnapshot(const std::string& path)
+{
+    const MappedFile file(path);
+    SnapshotReader reader(file);
+
+    for (const char c : SNAPSHOT_MAGIC) {
+        if (reader.Read<char>() != c) {
+            throw std::runtime_error("Not a search server snapshot: " + path);
+        }
+    }
+    if (reader.Read<uint32_t>() != SNAPSHOT_VERSION) {
+        throw std::runtime_error("Unsupported snapshot version: " + path);
+    }
+    if (reader.Read<uint32_t>() != SNAPSHOT_BYTE_ORDER) {
+        throw std::runtime_error("Snapshot byte order mismatch: " + path);
+    }
+
+    const auto corrupted = [&path] {
+        return std::runtime_error("Snapshot is corrupted: " + path);
+    };
+
+    std::vector<std::string_view> stop_words(reader.ReadCount(sizeof(uint32_t)));
+    for (auto& word : stop_words) {
+        word = reader.ReadString();
+    }
+    // Недопустимое стоп-слово - тоже повреждение снимка, а не ошибка аргумента
+    std::optional<SearchServer> loaded;
+    try {
+        loaded.emplace(stop_words);
+    } catch (const std::invalid_argument&) {
+        throw corrupted();
+    }
+    SearchServer& server = *loaded;
+
+    const size_t document_count = reader.ReadCount(4 * sizeof(int));
+    const int* ids = reader.ReadArray<int>(document_count);
+    const int* ratings = reader.ReadArray<int>(document_count);
+    const int32_t* statuses = reader.ReadArray<int32_t>(document_count);
+    const int* word_counts = reader.ReadArray<int>(document_count);
+    server.document_external_ids_.assign(ids, ids + document_count);
+    server.document_ratings_.assign(ratings, ratings + document_count);
+    server.document_word_counts_.assign(word_counts, word_counts + document_count);
+    server.document_statuses_.reserve(document_count);
+    for (size_t index = 0; index < document_count; ++index) {
+        if (ids[index] < 0 || word_counts[index] < 0 || statuses[index] < static_cast<int32_t>(DocumentStatus::ACTUAL)
+            || statuses[index] > static_cast<int32_t>(DocumentStatus::REMOVED)) {
+            throw corrupted();
+        }
+        server.document_statuses_.push_back(static_cast<DocumentStatus>(statuses[index]));
+        if (!server.document_indices_.emplace(ids[index], static_cast<int>(index)).second) {
+            throw corrupted();
+        }
+    }
+    server.document_ids_.insert(ids, ids + document_count);
+    server.document_removed_.assign(document_count, false);
+    server.UpdateDocumentCount();
+
+    const size_t word_count = reader.ReadCount(sizeof(uint32_t) + sizeof(uint64_t));
+    server.word_to_document_freqs_.reserve(word_count);
+    server.word_log_document_freqs_.reserve(word_count);
+    std::vector<Relevance> converted_term_freqs;
+    std::string_view previous_word;
+    for (size_t i = 0; i < word_count; ++i) {
+        const std::string_view word = reader.ReadString();
+        const size_t posting_count = reader.Read<uint64_t>();
+        const int* document_indices = reader.ReadArray<int>(posting_count);
+        const Relevance* term_freqs = ConvertTermFreqs(reader.ReadArray<double>(posting_count), posting_count, converted_term_freqs);
+
+        // Слова строго по возрастанию, индексы документов в списке - тоже: на этом держатся
+        // словари документов, PostingList и поиск галопом
+        if (i > 0 && word <= previous_word) {
+            throw corrupted();
+        }
+        previous_word = word;
+        // Слово - такое, какое AddDocument мог бы занести в индекс
+        if (word.empty() || word.find(' ') != std::string_view::npos || !IsValidWord(word) || server.IsStopWord(word)) {
+            throw corrupted();
+        }
+        for (size_t j = 0; j < posting_count; ++j) {
+            if (document_indices[j] < 0 || static_cast<size_t>(document_indices[j]) >= document_count
+                || (j > 0 && document_indices[j] <= document_indices[j - 1])) {
+                throw corrupted();
+            }
+            // TF = число вхождений / длина документа: в (0, 1], у документа есть слова
+            if (!(std::isfinite(term_freqs[j]) && term_freqs[j] > 0 && term_freqs[j] <= 1) || word_counts[document_indices[j]] == 0) {
+                throw corrupted();
+            }
+        }
+
+        const int term_id = server.terms_.Intern(word);
+        if (term_id != static_cast<int>(i)) {
+            throw corrupted();
+        }
+        server.word_to_document_freqs_.emplace_back(document_indices, term_freqs, posting_count);
+        server.word_log_document_freqs_.emplace_back();
+        server.UpdateWordDocumentFreq(term_id);
+    }
+    // Слова в снимке отсортированы, поэтому порядок id терминов совпадает с порядком слов
+    server.forward_index_.Assign(server.word_to_document_freqs_, document_count);
+    return std::move(server);
+}
@@ -0,0 +1,200 @@
+#include "segmented_search_server.h"
+
+#include <algorithm>
+#include <iterator>
+
+SegmentedSearchServer::~SegmentedSearchServer()
+{
+    {
+        std::lock_guard lock(merge_mutex_);
+        stopped_ = true;
+    }
+    merge_wake_.notify_all();
+    merger_.join();
+}
+
+void SegmentedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings)
+{
+    std::unique_lock lock(mutex_);
+    if (document_segments_.count(document_id) > 0) {
+        throw std::invalid_argument("Invalid document_id");
+    }
+    buffer_->AddDocument(document_id, document, status, ratings);
+    document_segments_[document_id] = buffer_id_;
+    if (static_cast<size_t>(buffer_->GetDocumentCount()) >= buffer_capacity_) {
+        SealBuffer();
+    }
+}
+
+void SegmentedSearchServer::RemoveDocument(int document_id)
+{
+    std::unique_lock lock(mutex_);
+    const auto it = document_segments_.find(document_id);
+    if (it == document_segments_.end()) {
+        return;
+    }
+    const uint64_t segment_id = it->second;
+    document_segments_.erase(it);
+    if (segment_id == buffer_id_) {
+        buffer_->RemoveDocument(document_id);
+        return;
+    }
+    for (Segment& segment : segments_) {
+        if (segment.id == segment_id) {
+            auto deleted_ids = std::make_shared<std::set<int>>(*segment.deleted_ids);
+            deleted_ids->insert(document_id);
+            segment.deleted_ids = std::move(deleted_ids);
+            break;
+        }
+    }
+    RequestMerge();
+}
+
+int SegmentedSearchServer::GetDocumentCount() const
+{
+    std::shared_lock lock(mutex_);
+    return static_cast<int>(document_segments_.size());
+}
+
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status, size_t max_result_count) const
+{
+    return FindTopDocuments(raw_query, [status](int, DocumentStatus document_status, int) {
+        return document_status == status;
+    }, max_result_count);
+}
+
+void SegmentedSearchServer::Flush()
+{
+    std::unique_lock lock(mutex_);
+    SealBuffer();
+}
+
+void SegmentedSearchServer::WaitForMerges()
+{
+    std::unique_lock lock(merge_mutex_);
+    merge_done_.wait(lock, [this] { return !merge_requested_ && !merging_; });
+}
+
+size_t SegmentedSearchServer::GetSegmentCount() const
+{
+    std::shared_lock lock(mutex_);
+    return segments_.size();
+}
+
+void SegmentedSearchServer::SealBuffer()
+{
+    if (buffer_->GetDocumentCount() == 0) {
+        return;
+    }
+    segments_.push_back({buffer_id_, std::make_shared<const FrozenSegment>(*buffer_), std::make_shared<const std::set<int>>()});
+    buffer_ = std::make_unique<SearchServer>(stop_words_);
+    buffer_id_ = next_segment_id_++;
+    RequestMerge();
+}
+
+void SegmentedSearchServer::RequestMerge()
+{
+    {
+        std::lock_guard lock(merge_mutex_);
+        merge_requested_ = true;
+    }
+    merge_wake_.notify_one();
+}
+
+void SegmentedSearchServer::MergeLoop()
+{
+    std::unique_lock lock(merge_mutex_);
+    while (true) {
+        merge_wake_.wait(lock, [this] { return stopped_ || merge_requested_; });
+        if (stopped_) {
+            return;
+        }
+        merge_requested_ = false;
+        merging_ = true;
+        lock.unlock();
+        while (MergeOnce()) {
+            std::lock_guard stop_lock(merge_mutex_);
+            if (stopped_) {
+                break;
+            }
+        }
+        lock.lock();
+        merging_ = false;
+        merge_done_.notify_all();
+    }
+}
+
+std::vector<size_t> SegmentedSearchServer::SelectMerge() const
+{
+    // Сегмент, в котором удалена хотя бы половина документов, переписывается отдельно
+    for (size_t i = 0; i < segments_.size(); ++i) {
+        if (segments_[i].deleted_ids->size() * 2 >= static_cast<size_t>(segments_[i].index->GetDocumentCount())) {
+            return {i};
+        }
+    }
+    // Уровень сегмента: наименьший L, при котором он не больше buffer_capacity * merge_factor^L.
+    // Сливаются merge_factor сегментов самого низкого заполненного уровня.
+    std::vector<std::vector<size_t>> levels;
+    for (size_t i = 0; i < segments_.size(); ++i) {
+        size_t level = 0;
+        for (size_t level_size = buffer_capacity_; segments_[i].GetLiveDocumentCount() > level_size; level_size *= merge_factor_) {
+            ++level;
+        }
+        if (levels.size() <= level) {
+            levels.resize(level + 1);
+        }
+        levels[level].push_back(i);
+        if (levels[level].size() == merge_factor_) {
+            return levels[level];
+        }
+    }
+    return {};
+}
+
+bool SegmentedSearchServer::MergeOnce()
+{
+    std::vector<Segment> sources;
+    {
+        std::shared_lock lock(mutex_);
+        for (const size_t index : SelectMerge()) {
+            sources.push_back(segments_[index]);
+        }
+    }
+    if (sources.empty()) {
+        return false;
+    }
+
+    // Слияние идёт без блокировки: источники неизменяемы, удаления на момент выбора уже учтены
+    std::vector<std::pair<const FrozenSegment*, const std::set<int>*>> merge_sources;
+    for (const Segment& source : sources) {
+        merge_sources.push_back({source.index.get(), source.deleted_ids.get()});
+    }
+    auto merged = std::make_shared<const FrozenSegment>(merge_sources);
+
+    std::unique_lock lock(mutex_);
+    Segment result{next_segment_id_++, std::move(merged), nullptr};
+    // Документы, удалённые из источников во время слияния, остаются удалёнными и в результате
+    std::set<int> deleted_ids;
+    auto insert_position = segments_.end();
+    for (const Segment& source : sources) {
+        const auto it = std::find_if(segments_.begin(), segments_.end(), [&source](const Segment& segment) {
+            return segment.id == source.id;
+        });
+        std::set_difference(it->deleted_ids->begin(), it->deleted_ids->end(),
+            source.deleted_ids->begin(), source.deleted_ids->end(), std::inserter(deleted_ids, deleted_ids.end()));
+        insert_position = segments_.erase(it);
+    }
+    for (const int document_id : result.index->GetDocumentIds()) {
+        const auto it = document_segments_.find(document_id);
+        if (it != document_segments_.end() && std::any_of(sources.begin(), sources.end(), [&it](const Segment& source) {
+            return source.id == it->second;
+        })) {
+            it->second = result.id;
+        }
+    }
+    result.deleted_ids = std::make_shared<const std::set<int>>(std::move(deleted_ids));
+    if (result.GetLiveDocumentCount() > 0) {
+        segments_.insert(insert_position, std::move(result));
+    }
+    return true;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+#include "frozen_segment.h"
+#include "search_server.h"
+#include "string_processing.h"
+#include "top_documents.h"
+
+// Индекс из небольшого изменяемого буфера записи и неизменяемых сегментов (LSM).
+// Новые документы попадают в буфер; заполненный буфер сжимается в сегмент (FrozenSegment).
+// Фоновый поток сливает сегменты одного уровня размера в один и при этом выбрасывает
+// удалённые документы. Поиск обходит буфер и все сегменты и объединяет их top-K;
+// IDF считается по всему корпусу, поэтому результат тот же, что у одного SearchServer.
+// Документы, удалённые из сегментов, до слияния учитываются в IDF, но не попадают в выдачу.
+class SegmentedSearchServer {
+public:
+    static constexpr size_t DEFAULT_BUFFER_CAPACITY = 10'000;
+    static constexpr size_t DEFAULT_MERGE_FACTOR = 4;
+
+    template <typename StringContainer>
+    explicit SegmentedSearchServer(const StringContainer& stop_words, size_t buffer_capacity = DEFAULT_BUFFER_CAPACITY, size_t merge_factor = DEFAULT_MERGE_FACTOR)
+        : stop_words_(MakeStopWords(stop_words))
+        , buffer_capacity_(std::max<size_t>(1, buffer_capacity))
+        , merge_factor_(std::max<size_t>(2, merge_factor))
+        , buffer_(std::make_unique<SearchServer>(stop_words_))
+    {
+        merger_ = std::thread([this] { MergeLoop(); });
+    }
+
+    explicit SegmentedSearchServer(const std::string& stop_words_text, size_t buffer_capacity = DEFAULT_BUFFER_CAPACITY, size_t merge_factor = DEFAULT_MERGE_FACTOR)
+        : SegmentedSearchServer(SplitIntoWords(stop_words_text), buffer_capacity, merge_factor)
+    {
+    }
+
+    SegmentedSearchServer(const SegmentedSearchServer&) = delete;
+    SegmentedSearchServer& operator=(const SegmentedSearchServer&) = delete;
+
+    ~SegmentedSearchServer();
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    void RemoveDocument(int document_id);
+
+    int GetDocumentCount() const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    // Превращает непустой буфер в сегмент
+    void Flush();
+
+    // Ждёт, пока фоновые слияния не закончатся
+    void WaitForMerges();
+
+    size_t GetSegmentCount() const;
+
+private:
+    struct Segment {
+        uint64_t id;
+        std::shared_ptr<const FrozenSegment> index;
+        // Удалённые из сегмента документы; при удалении заменяется копией
+        std::shared_ptr<const std::set<int>> deleted_ids;
+
+        size_t GetLiveDocumentCount() const
+        {
+            return index->GetDocumentCount() - deleted_ids->size();
+        }
+    };
+
+    const std::vector<std::string> stop_words_;
+    const size_t buffer_capacity_;
+    const size_t merge_factor_;
+
+    // Защищает буфер, список сегментов и размещение документов
+    mutable std::shared_mutex mutex_;
+    std::unique_ptr<SearchServer> buffer_;
+    uint64_t buffer_id_ = 0;
+    uint64_t next_segment_id_ = 1;
+    // От старых сегментов к новым
+    std::vector<Segment> segments_;
+    // Живой документ -> id сегмента (или буфера), в котором он лежит
+    std::unordered_map<int, uint64_t> document_segments_;
+
+    std::mutex merge_mutex_;
+    std::condition_variable merge_wake_;
+    std::condition_variable merge_done_;
+    bool merge_requested_ = false;
+    bool merging_ = false;
+    bool stopped_ = false;
+    std::thread merger_;
+
+    template <typename StringContainer>
+    static std::vector<std::string> MakeStopWords(const StringContainer& stop_words)
+    {
+        const auto unique_words = MakeUniqueNonEmptyStrings(stop_words);
+        return {unique_words.begin(), unique_words.end()};
+    }
+
+    // Вызывается под исключительной блокировкой mutex_
+    void SealBuffer();
+
+    void RequestMerge();
+
+    void MergeLoop();
+
+    // Сливает одну группу сегментов; false - сливать нечего
+    bool MergeOnce();
+
+    // Номера сегментов для следующего слияния или пустой вектор
+    std::vector<size_t> SelectMerge() const;
+};
+
+template <typename DocumentPredicate>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t max_result_count) const
+{
+    CorpusStatistics statistics;
+    TopDocumentsSelector selector(max_result_count);
+    std::vector<Segment> segments;
+    SearchServer::Query query;
+    {
+        // Под блокировкой только буфер; сегменты неизменяемы и обходятся уже без неё
+        std::shared_lock lock(mutex_);
+        segments = segments_;
+        buffer_->CollectStatistics(raw_query, statistics);
+        query = buffer_->ParseQuery(raw_query);
+        SearchServer::NormalizeQuery(query);
+        for (const Segment& segment : segments) {
+            segment.index->CollectStatistics(query.plus_words, statistics);
+        }
+        for (const Document& document : buffer_->FindTopDocuments(statistics, raw_query, document_predicate, max_result_count)) {
+            selector.Add(document);
+        }
+    }
+    for (const Segment& segment : segments) {
+        const std::set<int>& deleted_ids = *segment.deleted_ids;
+        const auto live_document_predicate = [&deleted_ids, &document_predicate](int document_id, DocumentStatus status, int rating) {
+            return deleted_ids.count(document_id) == 0 && document_predicate(document_id, status, rating);
+        };
+        for (const Document& document : segment.index->FindTopDocuments(statistics, query.plus_words, query.minus_words, live_document_predicate, max_result_count)) {
+            selector.Add(document);
+        }
+    }
+    return selector.Extract();
+}
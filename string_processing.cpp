@@ -1,17 +1,129 @@
 #include "string_processing.h"
 
-std::vector<std::string_view> SplitIntoWords(std::string_view text) {
-    std::vector<std::string_view> result;
-    const int64_t pos_end = text.npos;
-    while (true) {
-        int64_t space = text.find(' ');
-        result.push_back(space == pos_end ? text.substr(0) : text.substr(0, space));
-        if (space == pos_end) {
-            break;
+#include "cpu_features.h"
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Управляющие символы (коды 0..31) недопустимы в словах
+bool IsControlChar(char c) {
+    return static_cast<unsigned char>(c) < ' ';
+}
+
+// Общая часть всех реализаций: по маскам пробелов и управляющих символов блока
+// из block_size байт начиная с offset выделяет слова
+struct TokenizerState {
+    std::string_view text;
+    std::vector<std::string_view>& words;
+    size_t word_start = 0;
+    size_t first_invalid = std::string_view::npos;
+
+    void AddBlock(size_t offset, uint64_t space_mask, uint64_t control_mask) {
+        if (control_mask != 0 && first_invalid == std::string_view::npos) {
+            first_invalid = offset + __builtin_ctzll(control_mask);
         }
-        else {
-            text.remove_prefix(space + 1);
+        while (space_mask != 0) {
+            const size_t space = offset + __builtin_ctzll(space_mask);
+            words.push_back(text.substr(word_start, space - word_start));
+            word_start = space + 1;
+            space_mask &= space_mask - 1;
         }
     }
+
+    void AddTail(size_t offset) {
+        for (size_t pos = offset; pos < text.size(); ++pos) {
+            if (text[pos] == ' ') {
+                words.push_back(text.substr(word_start, pos - word_start));
+                word_start = pos + 1;
+            } else if (IsControlChar(text[pos]) && first_invalid == std::string_view::npos) {
+                first_invalid = pos;
+            }
+        }
+        words.push_back(text.substr(word_start));
+    }
+};
+
+size_t SplitIntoWordsScalar(std::string_view text, std::vector<std::string_view>& words) {
+    TokenizerState state{text, words};
+    state.AddTail(0);
+    return state.first_invalid;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("sse2")))
+size_t SplitIntoWordsSse2(std::string_view text, std::vector<std::string_view>& words) {
+    TokenizerState state{text, words};
+    const __m128i spaces = _mm_set1_epi8(' ');
+    const __m128i max_control = _mm_set1_epi8(' ' - 1);
+    size_t offset = 0;
+    for (; offset + 16 <= text.size(); offset += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + offset));
+        const uint64_t space_mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, spaces)));
+        // c <= 31 без знака: min(c, 31) == c
+        const uint64_t control_mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(chunk, max_control), chunk)));
+        state.AddBlock(offset, space_mask, control_mask);
+    }
+    state.AddTail(offset);
+    return state.first_invalid;
+}
+
+__attribute__((target("avx2")))
+size_t SplitIntoWordsAvx2(std::string_view text, std::vector<std::string_view>& words) {
+    TokenizerState state{text, words};
+    const __m256i spaces = _mm256_set1_epi8(' ');
+    const __m256i max_control = _mm256_set1_epi8(' ' - 1);
+    size_t offset = 0;
+    for (; offset + 32 <= text.size(); offset += 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + offset));
+        const uint64_t space_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, spaces)));
+        const uint64_t control_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(chunk, max_control), chunk)));
+        state.AddBlock(offset, space_mask, control_mask);
+    }
+    state.AddTail(offset);
+    return state.first_invalid;
+}
+
+#endif
+
+using SplitFunction = size_t (*)(std::string_view, std::vector<std::string_view>&);
+
+SplitFunction GetSplitFunction(SimdLevel level) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (level >= SimdLevel::AVX2 && IsSimdLevelSupported(SimdLevel::AVX2)) {
+        return SplitIntoWordsAvx2;
+    }
+    if (level >= SimdLevel::SSE2 && IsSimdLevelSupported(SimdLevel::SSE2)) {
+        return SplitIntoWordsSse2;
+    }
+#endif
+    return SplitIntoWordsScalar;
+}
+
+} // namespace
+
+std::vector<std::string_view> SplitIntoWords(std::string_view text) {
+    std::vector<std::string_view> result;
+    SplitIntoWords(text, result);
     return result;
 }
+
+void SplitIntoWords(std::string_view text, std::vector<std::string_view>& result) {
+    SplitIntoWordsChecked(text, result);
+}
+
+size_t SplitIntoWordsChecked(std::string_view text, std::vector<std::string_view>& result) {
+    static const SplitFunction split = GetSplitFunction(GetBestSimdLevel());
+    result.clear();
+    return split(text, result);
+}
+
+size_t SplitIntoWordsChecked(SimdLevel level, std::string_view text, std::vector<std::string_view>& result) {
+    result.clear();
+    return GetSplitFunction(level)(text, result);
+}
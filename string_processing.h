@@ -5,8 +5,21 @@
 #include <set>
 #include <iostream>
 
+#include "cpu_features.h"
+
 std::vector<std::string_view> SplitIntoWords(std::string_view text);
 
+// То же, но в переданный вектор: при повторном использовании память не выделяется
+void SplitIntoWords(std::string_view text, std::vector<std::string_view>& result);
+
+// Разбивает text по пробелам за один проход, заодно ища управляющие символы (коды 0..31).
+// Возвращает позицию первого такого символа или std::string_view::npos.
+// Реализация (AVX2, SSE2 или скалярная) выбирается по возможностям процессора.
+size_t SplitIntoWordsChecked(std::string_view text, std::vector<std::string_view>& result);
+
+// То же с явно заданной реализацией, если процессор её поддерживает; для тестов и замеров
+size_t SplitIntoWordsChecked(SimdLevel level, std::string_view text, std::vector<std::string_view>& result);
+
 
 
 template <typename StringContainer>
@@ -0,0 +1,89 @@
+#include "term_dictionary.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+TermDictionary::TermDictionary(const TermDictionary& other)
+    : blocks_(other.blocks_)
+    , pool_bytes_(other.pool_bytes_)
+    , terms_(other.terms_)
+    , slots_(other.slots_)
+{
+    // Хвост последнего блока остаётся за оригиналом
+}
+
+TermDictionary& TermDictionary::operator=(const TermDictionary& other)
+{
+    if (this != &other) {
+        TermDictionary copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+int TermDictionary::Intern(std::string_view term)
+{
+    if ((terms_.size() + 1) * 2 > slots_.size()) {
+        Rehash(std::max<size_t>(MIN_SLOT_COUNT, slots_.size() * 2));
+    }
+    const size_t slot = FindSlot(term);
+    if (slots_[slot] >= 0) {
+        return slots_[slot];
+    }
+    const int term_id = static_cast<int>(terms_.size());
+    terms_.push_back(Store(term));
+    slots_[slot] = term_id;
+    return term_id;
+}
+
+int TermDictionary::Find(std::string_view term) const
+{
+    if (slots_.empty()) {
+        return -1;
+    }
+    return slots_[FindSlot(term)];
+}
+
+size_t TermDictionary::MemoryUsage() const
+{
+    return pool_bytes_
+        + blocks_.capacity() * sizeof(blocks_[0])
+        + terms_.capacity() * sizeof(std::string_view)
+        + slots_.capacity() * sizeof(int);
+}
+
+size_t TermDictionary::FindSlot(std::string_view term) const
+{
+    const size_t mask = slots_.size() - 1;
+    size_t slot = std::hash<std::string_view>{}(term) & mask;
+    while (slots_[slot] >= 0 && terms_[slots_[slot]] != term) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void TermDictionary::Rehash(size_t slot_count)
+{
+    slots_.assign(slot_count, -1);
+    for (int term_id = 0; term_id < static_cast<int>(terms_.size()); ++term_id) {
+        slots_[FindSlot(terms_[term_id])] = term_id;
+    }
+}
+
+std::string_view TermDictionary::Store(std::string_view term)
+{
+    if (term.empty()) {
+        return {};
+    }
+    if (term.size() > block_capacity_ - block_used_) {
+        block_capacity_ = std::max(BLOCK_SIZE, term.size());
+        blocks_.emplace_back(new char[block_capacity_]);
+        pool_bytes_ += block_capacity_;
+        block_used_ = 0;
+    }
+    char* data = blocks_.back().get() + block_used_;
+    std::memcpy(data, term.data(), term.size());
+    block_used_ += term.size();
+    return {data, term.size()};
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Словарь терминов: каждая уникальная строка хранится один раз в пуле блоков
+// и получает постоянный целочисленный id. string_view, выданные словарём,
+// действительны всё время жизни словаря и его копий.
+class TermDictionary {
+public:
+    TermDictionary() = default;
+
+    // Копия разделяет с оригиналом уже заполненные блоки (они не изменяются),
+    // а новые термины складывает в собственные блоки.
+    TermDictionary(const TermDictionary& other);
+
+    TermDictionary& operator=(const TermDictionary& other);
+
+    TermDictionary(TermDictionary&&) = default;
+
+    TermDictionary& operator=(TermDictionary&&) = default;
+
+    // Возвращает id термина, добавляя его при первом обращении
+    int Intern(std::string_view term);
+
+    // Возвращает id термина или -1, если термина нет
+    int Find(std::string_view term) const;
+
+    std::string_view GetTerm(int term_id) const
+    {
+        return terms_[term_id];
+    }
+
+    size_t size() const
+    {
+        return terms_.size();
+    }
+
+    size_t MemoryUsage() const;
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    static constexpr size_t MIN_SLOT_COUNT = 16;
+
+    std::vector<std::shared_ptr<char[]>> blocks_;
+    size_t block_capacity_ = 0;
+    size_t block_used_ = 0;
+    size_t pool_bytes_ = 0;
+    std::vector<std::string_view> terms_;
+    // Хеш-индекс с открытой адресацией: в ячейках id терминов, -1 - свободно
+    std::vector<int> slots_;
+
+    std::string_view Store(std::string_view term);
+
+    size_t FindSlot(std::string_view term) const;
+
+    void Rehash(size_t slot_count);
+};
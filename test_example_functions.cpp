@@ -66,7 +66,7 @@ void RemoveDuplicates(SearchServer& search_server) {
     std::vector<int> found_duplicates;
 
     for (int document_id : search_server) {
-        auto& freqs = search_server.GetWordFrequencies(document_id);
+        const auto freqs = search_server.GetWordFrequencies(document_id);
         std::set<std::string_view> words;
 
         std::transform(freqs.begin(), freqs.end(), std::inserter(words, words.begin()),
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "document.h"
+
+// Порядок выдачи: по убыванию релевантности, при равной (с точностью GetRelevanceTolerance) - по убыванию рейтинга.
+inline bool IsMoreRelevant(const Document& lhs, const Document& rhs)
+{
+    if (std::abs(lhs.relevance - rhs.relevance) < GetRelevanceTolerance(std::max(std::abs(lhs.relevance), std::abs(rhs.relevance)))) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.relevance > rhs.relevance;
+}
+
+// Потоковый отбор max_count лучших документов.
+// Куча хранит не более max_count элементов, на вершине - худший из отобранных.
+class TopDocumentsSelector {
+public:
+    explicit TopDocumentsSelector(size_t max_count)
+        : max_count_(max_count)
+    {
+    }
+
+    void Add(const Document& document)
+    {
+        if (max_count_ == 0) {
+            return;
+        }
+        if (heap_.size() < max_count_) {
+            heap_.push_back(document);
+            std::push_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+        } else if (IsMoreRelevant(document, heap_.front())) {
+            std::pop_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+            heap_.back() = document;
+            std::push_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+        }
+    }
+
+    // Худший из отобранных, если отобрано уже max_count документов, иначе nullptr.
+    // Документ с релевантностью меньше, чем у худшего, больше чем на GetRelevanceTolerance, в выборку не попадёт.
+    const Document* GetWorst() const
+    {
+        return max_count_ > 0 && heap_.size() == max_count_ ? &heap_.front() : nullptr;
+    }
+
+    void Merge(const TopDocumentsSelector& other)
+    {
+        for (const Document& document : other.heap_) {
+            Add(document);
+        }
+    }
+
+    std::vector<Document> Extract()
+    {
+        std::sort_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+        return std::move(heap_);
+    }
+
+    // Для повторного использования без выделения памяти: Reset, Add..., затем Sort
+    void Reset(size_t max_count)
+    {
+        max_count_ = max_count;
+        heap_.clear();
+    }
+
+    const std::vector<Document>& Sort()
+    {
+        std::sort_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+        return heap_;
+    }
+
+private:
+    size_t max_count_;
+    std::vector<Document> heap_;
+};
+
+template <typename Policy>
+std::vector<Document> SelectTopDocuments(const Policy&, const std::vector<Document>& documents, size_t max_count)
+{
+    // Параллельно: у каждого потока своя куча, затем кучи сливаются
+    if constexpr (std::is_same_v<std::decay_t<Policy>, std::execution::parallel_policy>) {
+        const size_t chunk_count = std::max(1u, std::thread::hardware_concurrency());
+        if (chunk_count > 1 && documents.size() > chunk_count * max_count) {
+            const size_t chunk_size = (documents.size() + chunk_count - 1) / chunk_count;
+            std::vector<TopDocumentsSelector> selectors(chunk_count, TopDocumentsSelector(max_count));
+            std::vector<size_t> chunks(chunk_count);
+            for (size_t i = 0; i < chunk_count; ++i) {
+                chunks[i] = i;
+            }
+            std::for_each(std::execution::par, chunks.begin(), chunks.end(), [&](size_t chunk) {
+                const size_t first = std::min(documents.size(), chunk * chunk_size);
+                const size_t last = std::min(documents.size(), first + chunk_size);
+                for (size_t i = first; i < last; ++i) {
+                    selectors[chunk].Add(documents[i]);
+                }
+            });
+            for (size_t i = 1; i < chunk_count; ++i) {
+                selectors[0].Merge(selectors[i]);
+            }
+            return selectors[0].Extract();
+        }
+    }
+    TopDocumentsSelector selector(max_count);
+    for (const Document& document : documents) {
+        selector.Add(document);
+    }
+    return selector.Extract();
+}